@@ -13,17 +13,23 @@ import android.util.Log
 import android.view.Surface
 import java.nio.ByteBuffer
 
-abstract class ByteArraySinker {
+abstract class ByteBufferSinker {
+    /**
+     * The buffer is only valid for the duration of this call, it wraps the codec's own
+     * output memory, consume or copy it before returning.
+     */
     abstract fun sink(kind: Int,
                       flags: Int,
                       timestamp: Long,
-                      buf: ByteArray)
+                      buf: ByteBuffer,
+                      offset: Int,
+                      size: Int)
 }
 
 class Video {
     class VideoEncoder(
         configure: VideoEncoderConfigure,
-        private val sinker: ByteArraySinker
+        private val sinker: ByteBufferSinker
     ) {
         private var isRunning: Boolean = false
         private var videoFormat: VideoFormat = VideoFormat.NV12
@@ -101,21 +107,19 @@ class Video {
             worker = Thread {
                 Process.setThreadPriority(Process.THREAD_PRIORITY_VIDEO)
 
-                val buffer = ByteArray(2 * 1024 * 1024)
-
                 while (isRunning) {
                     try {
                         val index = codec.dequeueOutputBuffer(bufferInfo, -1)
                         if (index >= 0) {
                             val outputBuffer = codec.getOutputBuffer(index)
                             if (outputBuffer != null && bufferInfo.size > 0) {
-                                outputBuffer.get(buffer, 0, bufferInfo.size)
-
                                 sinker.sink(
                                     StreamType.VIDEO.flag,
                                     bufferInfo.flags,
                                     bufferInfo.presentationTimeUs,
-                                    buffer.sliceArray(bufferInfo.offset until bufferInfo.size),
+                                    outputBuffer,
+                                    bufferInfo.offset,
+                                    bufferInfo.size,
                                 )
                             }
 
@@ -236,13 +240,16 @@ class Video {
             }
         }
 
-        fun sink(buf: ByteArray, flags: Int, timestamp: Long) {
+        fun sink(buf: ByteBuffer, flags: Int, timestamp: Long) {
             try {
                 val index = codec.dequeueInputBuffer(-1)
                 if (index >= 0) {
+                    // duplicate so the caller's position survives, the bytes themselves are
+                    // not copied.
+                    val size = buf.remaining()
                     codec.getInputBuffer(index)?.clear()
-                    codec.getInputBuffer(index)?.put(buf)
-                    codec.queueInputBuffer(index, 0, buf.size, timestamp, flags)
+                    codec.getInputBuffer(index)?.put(buf.duplicate())
+                    codec.queueInputBuffer(index, 0, size, timestamp, flags)
                 }
             } catch (e: Exception) {
                 Log.w("com.github.mycrl.hylarana", "VideoDecoder sink exception", e)
@@ -347,12 +354,13 @@ class Audio {
             }
         }
 
-        fun sink(buf: ByteArray, flags: Int, timestamp: Long) {
+        fun sink(buf: ByteBuffer, flags: Int, timestamp: Long) {
             val index = codec.dequeueInputBuffer(1000)
             if (index >= 0) {
+                val size = buf.remaining()
                 codec.getInputBuffer(index)?.clear()
-                codec.getInputBuffer(index)?.put(buf)
-                codec.queueInputBuffer(index, 0, buf.size, timestamp, flags)
+                codec.getInputBuffer(index)?.put(buf.duplicate())
+                codec.queueInputBuffer(index, 0, size, timestamp, flags)
             }
         }
 
@@ -380,7 +388,7 @@ class Audio {
 
     class AudioEncoder(
         private val record: AudioRecord?,
-        private val sinker: ByteArraySinker
+        private val sinker: ByteBufferSinker
     ) {
         private var isRunning: Boolean = false
 
@@ -411,21 +419,19 @@ class Audio {
             worker = Thread {
                 Process.setThreadPriority(Process.THREAD_PRIORITY_URGENT_AUDIO)
 
-                val buffer = ByteArray(1024 * 1024)
-
                 while (isRunning) {
                     try {
                         val index = codec.dequeueOutputBuffer(bufferInfo, -1)
                         if (index >= 0) {
                             val outputBuffer = codec.getOutputBuffer(index)
                             if (outputBuffer != null && bufferInfo.size > 0) {
-                                outputBuffer.get(buffer, 0, bufferInfo.size)
-
                                 sinker.sink(
                                     StreamType.AUDIO.flag,
                                     bufferInfo.flags,
                                     bufferInfo.presentationTimeUs,
-                                    buffer.sliceArray(bufferInfo.offset until bufferInfo.size),
+                                    outputBuffer,
+                                    bufferInfo.offset,
+                                    bufferInfo.size,
                                 )
                             }
 
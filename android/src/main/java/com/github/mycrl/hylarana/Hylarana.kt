@@ -4,6 +4,7 @@ import kotlinx.serialization.SerialName
 import kotlinx.serialization.Serializable
 import kotlinx.serialization.encodeToString
 import kotlinx.serialization.json.Json
+import java.nio.ByteBuffer
 
 /**
  * Data Stream Receiver Adapter
@@ -14,12 +15,15 @@ internal abstract class HylaranaReceiverAdapterObserver {
     /**
      * Triggered when data arrives in the network.
      *
+     * The buffer wraps native memory without copying and is only valid for the duration of
+     * this call, consume or copy it before returning.
+     *
      * Note: If the buffer is empty, the current network connection has been closed or suddenly interrupted.
      */
     abstract fun sink(/*StreamType*/ kind: Int,
                       flags: Int,
                       timestamp: Long,
-                      bytes: ByteArray
+                      bytes: ByteBuffer
     ): Boolean
 
     /**
@@ -95,13 +99,17 @@ data class MediaAudioStreamDescription(
 
 @Serializable
 data class MediaStreamDescription(
-    val video: MediaVideoStreamDescription?,
+    /**
+     * One entry per video track in track order, empty when the sender
+     * captures no video.
+     */
+    val videos: List<MediaVideoStreamDescription>,
     val audio: MediaAudioStreamDescription?,
 )
 
 class HylaranaSenderAdapter(
     private val getPortHandle: () -> Int,
-    private val sendHandle: (Int, Int, Long, ByteArray) -> Boolean,
+    private val sendHandle: (Int, Int, Long, ByteBuffer, Int, Int) -> Boolean,
     private val releaseHandle: () -> Unit,
 ) {
     fun getPort(): Int {
@@ -110,13 +118,16 @@ class HylaranaSenderAdapter(
 
     /**
      * send stream buffer to sender.
+     *
+     * The buffer must be direct, the native side reads `size` bytes starting at `offset`
+     * straight from its backing memory.
      */
     fun send(
         kind: Int,
         flags: Int,
-        timestamp: Long, bytes: ByteArray
+        timestamp: Long, bytes: ByteBuffer, offset: Int, size: Int
     ): Boolean {
-        return sendHandle(kind, flags, timestamp, bytes)
+        return sendHandle(kind, flags, timestamp, bytes, offset, size)
     }
 
     /**
@@ -156,13 +167,15 @@ internal class Hylarana {
             {
                 if (sender != 0L) senderGetPort(sender) else 0
             },
-            { kind, flags, timestamp, bytes ->
+            { kind, flags, timestamp, bytes, offset, size ->
                 if (sender != 0L) senderWrite(
                     sender,
                     kind,
                     flags,
                     timestamp,
-                    bytes
+                    bytes,
+                    offset,
+                    size
                 ) else false
             },
             {
@@ -220,13 +233,17 @@ internal class Hylarana {
 
     /**
      * Sends the packet to the sender instance.
+     *
+     * The buffer must be direct so the native side can read it without a copy.
      */
     private external fun senderWrite(
         sender: Long,
         kind: Int,
         flags: Int,
         timestamp: Long,
-        bytes: ByteArray,
+        bytes: ByteBuffer,
+        offset: Int,
+        size: Int,
     ): Boolean
 
     /**
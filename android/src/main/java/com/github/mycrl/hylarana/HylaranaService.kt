@@ -4,6 +4,7 @@ import android.media.AudioRecord
 import android.media.AudioTrack
 import android.util.Log
 import android.view.Surface
+import java.nio.ByteBuffer
 import kotlin.Exception
 
 data class HylaranaSenderConfigure(
@@ -33,10 +34,13 @@ abstract class HylaranaReceiverObserver {
     abstract val track: AudioTrack?
 
     /**
-     * You can choose to implement this function, and the underlying transport layer will give you a c
-     * opy of the audio and video data, with the `kind` parameter indicating the type of packet.
+     * You can choose to implement this function, and the underlying transport layer will give you a
+     * view of the audio and video data, with the `kind` parameter indicating the type of packet.
+     *
+     * The buffer wraps native memory and is only valid for the duration of this call, copy it if
+     * you need to keep it.
      */
-    open fun sink(bytes: ByteArray, kind: StreamType) {}
+    open fun sink(bytes: ByteBuffer, kind: StreamType) {}
 
     /**
      * Called when the receiver is closed, the likely reason is because the underlying transport
@@ -104,8 +108,8 @@ class HylaranaService {
                         private val audioDecoder = observer.track?.let { Audio.AudioDecoder(it) }
                         private val videoDecoder = Video.VideoDecoder(
                             observer.surface,
-                            configure.description.video?.size?.width ?: 2560,
-                            configure.description.video?.size?.height ?: 1440
+                            configure.description.videos.firstOrNull()?.size?.width ?: 2560,
+                            configure.description.videos.firstOrNull()?.size?.height ?: 1440
                         )
 
                         init {
@@ -117,7 +121,7 @@ class HylaranaService {
                             kind: Int,
                             flags: Int,
                             timestamp: Long,
-                            bytes: ByteArray
+                            bytes: ByteBuffer
                         ): Boolean {
                             try {
                                 if (isReleased) {
@@ -197,15 +201,17 @@ class HylaranaSender(
     private var isReleased = false
 
     private val videoEncoder: Video.VideoEncoder =
-        Video.VideoEncoder(configure.video, object : ByteArraySinker() {
+        Video.VideoEncoder(configure.video, object : ByteBufferSinker() {
             override fun sink(
                 kind: Int,
                 flags: Int,
                 timestamp: Long,
-                buf: ByteArray
+                buf: ByteBuffer,
+                offset: Int,
+                size: Int
             ) {
                 if (!isClosed) {
-                    if (!sender.send(kind, flags, timestamp, buf)) {
+                    if (!sender.send(kind, flags, timestamp, buf, offset, size)) {
                         isClosed = true
                         observer.close()
                     }
@@ -214,15 +220,17 @@ class HylaranaSender(
         })
 
     private val audioEncoder: Audio.AudioEncoder =
-        Audio.AudioEncoder(record, object : ByteArraySinker() {
+        Audio.AudioEncoder(record, object : ByteBufferSinker() {
             override fun sink(
                 kind: Int,
                 flags: Int,
                 timestamp: Long,
-                buf: ByteArray
+                buf: ByteBuffer,
+                offset: Int,
+                size: Int
             ) {
                 if (!isClosed) {
-                    if (!sender.send(kind, flags, timestamp, buf)) {
+                    if (!sender.send(kind, flags, timestamp, buf, offset, size)) {
                         isClosed = true
                         observer.close()
                     }
@@ -250,11 +258,13 @@ class HylaranaSender(
     fun getDescription(): MediaStreamDescription {
         val audio = Audio.getAudioCodecConfigure()
         return MediaStreamDescription(
-            MediaVideoStreamDescription(
-                fps = configure.video.frameRate,
-                bitRate = configure.video.bitRate,
-                format = videoEncoder.getFormat().flag,
-                size = Size(width = configure.video.width, height = configure.video.height),
+            listOf(
+                MediaVideoStreamDescription(
+                    fps = configure.video.frameRate,
+                    bitRate = configure.video.bitRate,
+                    format = videoEncoder.getFormat().flag,
+                    size = Size(width = configure.video.width, height = configure.video.height),
+                )
             ),
             MediaAudioStreamDescription(
                 sampleRate = audio.sampleRate,
@@ -8,7 +8,7 @@ use anyhow::Result;
 use common::{logger, runtime::get_runtime_handle};
 use jni::{
     JNIEnv, JavaVM,
-    objects::{JByteArray, JClass, JObject, JString},
+    objects::{JByteArray, JByteBuffer, JClass, JObject, JString},
     sys::JNI_VERSION_1_6,
 };
 
@@ -203,12 +203,14 @@ extern "system" fn sender_write(
     ty: i32,
     flags: i32,
     timestamp: i64,
-    buf: JByteArray,
+    buf: JByteBuffer,
+    offset: i32,
+    size: i32,
 ) -> bool {
     assert!(!sender.is_null());
 
     ok_or_check(&mut env, |mut env| {
-        unsafe { &*sender }.sink(&mut env, ty, flags, timestamp, buf)
+        unsafe { &*sender }.sink(&mut env, ty, flags, timestamp, &buf, offset, size)
     })
     .unwrap_or(false)
 }
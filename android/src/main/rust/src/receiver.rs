@@ -14,16 +14,22 @@ struct ReceiverSink(GlobalRef);
 impl TransportReceiverSink for ReceiverSink {
     fn sink(&mut self, buffer: Buffer<Bytes>) -> bool {
         let mut env = get_current_env();
-        let bytes = if let Ok(it) = env.byte_array_from_slice(&buffer.data) {
-            it.into()
-        } else {
-            return false;
+
+        // Wraps the packet bytes as a direct byte buffer instead of copying
+        // them into a java array. The wrapper only stays valid for the
+        // duration of this call, the kotlin side must consume it before
+        // returning.
+        let bytes = match unsafe {
+            env.new_direct_byte_buffer(buffer.data.as_ptr() as *mut u8, buffer.data.len())
+        } {
+            Ok(it) => it,
+            Err(_) => return false,
         };
 
         let ret = env.call_method(
             self.0.as_obj(),
             "sink",
-            "(IIJ[B)Z",
+            "(IIJLjava/nio/ByteBuffer;)Z",
             &[
                 JValue::Int(buffer.stream as i32),
                 JValue::Int(buffer.ty as i32),
@@ -1,9 +1,9 @@
-use anyhow::Result;
+use anyhow::{Result, anyhow};
 use transport::{Buffer, BufferType, StreamType, TransportSender};
 
 use jni::{
     JNIEnv,
-    objects::{JByteArray, JString},
+    objects::{JByteBuffer, JString},
 };
 
 pub struct Sender(TransportSender);
@@ -25,23 +25,43 @@ impl Sender {
         ty: i32,
         flags: i32,
         timestamp: i64,
-        array: JByteArray,
+        buffer: &JByteBuffer,
+        offset: i32,
+        size: i32,
     ) -> Result<bool> {
+        // The kotlin side hands over media codec's direct output buffer, so
+        // the packet bytes are read straight from the codec's memory into the
+        // pooled transport buffer without crossing a java heap array first.
+        let ptr = env.get_direct_buffer_address(buffer)?;
+        let capacity = env.get_direct_buffer_capacity(buffer)?;
+
+        let offset = offset as usize;
+        let size = size as usize;
+        if offset + size > capacity {
+            return Err(anyhow!(
+                "direct buffer range out of bounds, offset={}, size={}, capacity={}",
+                offset,
+                size,
+                capacity
+            ));
+        }
+
         Ok(self
             .0
             .send(Buffer {
                 data: {
-                    let size = env.get_array_length(&array)? as usize;
                     let mut bytes = Buffer::<()>::with_capacity(size);
                     let start = bytes.len() - size;
 
-                    env.get_byte_array_region(array, 0, unsafe {
-                        std::mem::transmute::<&mut [u8], &mut [i8]>(&mut bytes[start..])
-                    })?;
+                    bytes[start..].copy_from_slice(unsafe {
+                        std::slice::from_raw_parts(ptr.add(offset), size)
+                    });
 
                     bytes
                 },
                 stream: StreamType::try_from(ty as u8)?,
+                // The android adapter feeds a single screen track.
+                track: 0,
                 ty: BufferType::try_from(flags as u8)?,
                 timestamp: timestamp as u64,
             })
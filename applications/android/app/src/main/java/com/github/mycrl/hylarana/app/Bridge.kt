@@ -347,7 +347,11 @@ class Bridge {
 
     @Serializable
     data class SenderMediaOptions(
-        val video: SenderMediaStreamOptions<SenderVideoMediaStreamOptions>?,
+        /**
+         * Every entry becomes an independently encoded video track multiplexed
+         * over the same connection, the android sender only uses the first one.
+         */
+        val videos: List<SenderMediaStreamOptions<SenderVideoMediaStreamOptions>>,
         val audio: SenderMediaStreamOptions<SenderAudioMediaStreamOptions>?,
     )
 
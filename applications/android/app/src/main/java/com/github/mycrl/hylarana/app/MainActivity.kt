@@ -170,7 +170,7 @@ class MainActivity : ComponentActivity() {
                 // Creation is only allowed when it is free.
                 if (status == Bridge.Status.Idle &&
                     serviceBinder != null &&
-                    options.media.video != null
+                    options.media.videos.isNotEmpty()
                 ) {
 
                     // Request screen recording permission first.
@@ -186,10 +186,10 @@ class MainActivity : ComponentActivity() {
                                     options = options.transport,
                                     video = Video.VideoEncoder.VideoEncoderConfigure(
                                         format = MediaCodecInfo.CodecCapabilities.COLOR_FormatSurface,
-                                        frameRate = options.media.video.options.frameRate,
-                                        bitRate = options.media.video.options.bitRate,
-                                        height = options.media.video.options.height,
-                                        width = options.media.video.options.width,
+                                        frameRate = options.media.videos.first().options.frameRate,
+                                        bitRate = options.media.videos.first().options.bitRate,
+                                        height = options.media.videos.first().options.height,
+                                        width = options.media.videos.first().options.width,
                                     )
                                 ), object : HylaranaCoreService.Observer() {
                                     override fun onClosed() {
@@ -232,8 +232,8 @@ class MainActivity : ComponentActivity() {
                 if (status == Bridge.Status.Idle && serviceBinder != null) {
                     isSurfaceShow = true
 
-                    remoteVideoWidth = description.video?.size?.width ?: 1280
-                    remoteVideoHeight = description.video?.size?.height ?: 720
+                    remoteVideoWidth = description.videos.firstOrNull()?.size?.width ?: 1280
+                    remoteVideoHeight = description.videos.firstOrNull()?.size?.height ?: 720
 
                     serviceBinder!!.createReceiver(
                         surface,
@@ -23,7 +23,7 @@ pub enum Status {
 pub struct CoreService {
     status: Arc<Mutex<Status>>,
     sender: Mutex<Option<HylaranaSender>>,
-    receiver: Mutex<Option<(HylaranaReceiver, Arc<AVFrameStreamPlayer<'static>>)>>,
+    receiver: Mutex<Option<(HylaranaReceiver, Arc<AVFrameStreamPlayer>)>>,
 }
 
 impl CoreService {
@@ -151,7 +151,7 @@ export interface Transport {
 export interface SenderOptions {
     transport: Transport;
     media: {
-        video: {
+        videos: {
             source: Source;
             options: {
                 codec: VideoEncoder;
@@ -161,7 +161,7 @@ export interface SenderOptions {
                 bit_rate: number;
                 key_frame_interval: number;
             };
-        } | null;
+        }[];
         audio: {
             source: Source;
             options: {
@@ -178,7 +178,7 @@ export interface ReceiverOptions {
 }
 
 export interface MediaStreamDescription {
-    video?: {
+    videos: {
         format: VideoFormat;
         size: {
             width: number;
@@ -186,7 +186,7 @@ export interface MediaStreamDescription {
         };
         fps: number;
         bit_rate: number;
-    };
+    }[];
     audio?: {
         sample_rate: number;
         channels: number;
@@ -40,17 +40,19 @@ export async function createSender(
                 latency: settings.network.latency,
             },
             media: {
-                video: {
-                    source: display,
-                    options: {
-                        codec: settings.codec.encoder,
-                        frame_rate: settings.video.frame_rate,
-                        width: settings.video.width,
-                        height: settings.video.height,
-                        bit_rate: settings.video.bit_rate,
-                        key_frame_interval: settings.video.key_frame_interval,
+                videos: [
+                    {
+                        source: display,
+                        options: {
+                            codec: settings.codec.encoder,
+                            frame_rate: settings.video.frame_rate,
+                            width: settings.video.width,
+                            height: settings.video.height,
+                            bit_rate: settings.video.bit_rate,
+                            key_frame_interval: settings.video.key_frame_interval,
+                        },
                     },
-                },
+                ],
                 audio: {
                     source: audio,
                     options: {
@@ -55,19 +55,23 @@ export default function ({ offscreen }: { offscreen: boolean }) {
                                         </div>
                                     </div>
                                     <div className='description'>
-                                        {it.metadata?.description.video && (
+                                        {it.metadata?.description.videos[0] && (
                                             <div className='sub'>
                                                 <p>{locales.Video} - </p>
                                                 <span>
                                                     {locales.Codec}: H264 / {locales.VideoSize}:{" "}
-                                                    {it.metadata?.description.video?.size.width}x
-                                                    {it.metadata?.description.video?.size.height} /
-                                                    {locales.VideoFrameRate}:{" "}
-                                                    {it.metadata?.description.video?.fps} /{" "}
+                                                    {it.metadata?.description.videos[0]?.size.width}
+                                                    x
+                                                    {
+                                                        it.metadata?.description.videos[0]?.size
+                                                            .height
+                                                    }{" "}
+                                                    /{locales.VideoFrameRate}:{" "}
+                                                    {it.metadata?.description.videos[0]?.fps} /{" "}
                                                     {locales.BitRate}:
-                                                    {it.metadata?.description.video?.bit_rate} /
+                                                    {it.metadata?.description.videos[0]?.bit_rate} /
                                                     {locales.VideoFormat}:{" "}
-                                                    {it.metadata?.description.video?.format}
+                                                    {it.metadata?.description.videos[0]?.format}
                                                 </span>
                                             </div>
                                         )}
@@ -152,7 +152,9 @@ where
     V: FrameConsumer<Frame = VideoFrame>,
     A: FrameConsumer<Frame = AudioFrame>,
 {
-    pub video: Option<SourceCaptureOptions<V, VideoCaptureSourceDescription>>,
+    /// Several video sources can be captured at once, each with its own
+    /// consumer, e.g. one entry per shared screen.
+    pub videos: Vec<SourceCaptureOptions<V, VideoCaptureSourceDescription>>,
     pub audio: Option<SourceCaptureOptions<A, AudioCaptureSourceDescription>>,
 }
 
@@ -163,7 +165,7 @@ where
 {
     fn default() -> Self {
         Self {
-            video: None,
+            videos: Vec::new(),
             audio: None,
         }
     }
@@ -195,18 +197,18 @@ impl Capture {
     /// Create a capture and start capturing audio and video frames by
     /// specifying the source to be captured.
     pub fn start<V, A>(
-        CaptureOptions { video, audio }: CaptureOptions<V, A>,
+        CaptureOptions { videos, audio }: CaptureOptions<V, A>,
     ) -> Result<Self, CaptureError>
     where
         V: FrameConsumer<Frame = VideoFrame> + 'static,
         A: FrameConsumer<Frame = AudioFrame> + 'static,
     {
-        let mut devices = Vec::with_capacity(3);
+        let mut devices = Vec::with_capacity(videos.len() + 1);
 
-        if let Some(SourceCaptureOptions {
+        for SourceCaptureOptions {
             description,
             consumer,
-        }) = video
+        } in videos
         {
             let screen = ScreenCapture::default();
             screen.start(description, consumer)?;
@@ -1,7 +1,10 @@
 use crate::{CaptureHandler, FrameConsumer, Source, SourceType, VideoCaptureSourceDescription};
 
 use std::{
-    sync::{atomic::{AtomicBool, Ordering}, Arc},
+    sync::{
+        Arc,
+        atomic::{AtomicBool, Ordering},
+    },
     thread,
     time::Duration,
 };
@@ -9,6 +12,7 @@ use std::{
 use common::{
     Size,
     frame::{VideoFormat, VideoFrame, VideoSubFormat},
+    scheduler::PipelineRole,
     win32::{EasyTexture, MediaThreadClass},
 };
 
@@ -149,6 +153,9 @@ impl GraphicsCaptureApiHandler for WindowsCapture {
         thread::Builder::new()
             .name("WindowsScreenCaptureThread".to_string())
             .spawn(move || {
+                // The mmcss class keeps the multimedia scheduler involved,
+                // the role raises the plain thread priority on top of it.
+                PipelineRole::Capture.apply();
                 let thread_class_guard = MediaThreadClass::Capture.join().ok();
 
                 let mut func = || {
@@ -1,4 +1,5 @@
 mod audio;
+mod pool;
 mod video;
 
 pub use self::{
@@ -6,6 +7,10 @@ pub use self::{
         AudioDecoder, AudioDecoderError, AudioEncoder, AudioEncoderError,
         create_opus_identification_header,
     },
+    pool::{
+        acquire_video_decoder, acquire_video_encoder, prewarm_video_decoder, prewarm_video_encoder,
+        release_video_decoder, release_video_encoder,
+    },
     video::{
         CodecError, CodecType, VideoDecoder, VideoDecoderError, VideoEncoder, VideoEncoderError,
     },
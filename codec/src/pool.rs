@@ -0,0 +1,133 @@
+// Warm pool of video codec contexts.
+//
+// Opening a video codec negotiates with the driver and allocates device and
+// frame contexts, which on hardware backends takes hundreds of milliseconds
+// and dominates the time from "start casting" to the first frame. The pool
+// lets the application pre-open contexts for its usual settings at process
+// start and recycle them between sessions, so creating a sender or receiver
+// only costs a buffer flush instead of a full codec open.
+
+use std::sync::{LazyLock, Mutex};
+
+use common::codec::{VideoDecoderType, VideoEncoderType};
+
+use crate::{
+    VideoDecoder, VideoDecoderError, VideoDecoderSettings, VideoEncoder, VideoEncoderError,
+    VideoEncoderSettings,
+};
+
+// How many idle contexts are kept per pool, anything released beyond this is
+// simply dropped. Hardware contexts pin driver resources, so the pool stays
+// small.
+const MAX_IDLE: usize = 4;
+
+// The bitrate is retuned on acquire and the direct3d device is process-wide,
+// neither participates in the key. Everything else requires a re-open to
+// change, so two settings with the same key are interchangeable.
+type EncoderKey = (VideoEncoderType, u8, u32, u32, u32);
+
+fn encoder_key(settings: &VideoEncoderSettings) -> EncoderKey {
+    (
+        settings.codec,
+        settings.frame_rate,
+        settings.width,
+        settings.height,
+        settings.key_frame_interval,
+    )
+}
+
+static VIDEO_ENCODERS: LazyLock<Mutex<Vec<(EncoderKey, VideoEncoder)>>> =
+    LazyLock::new(Default::default);
+
+static VIDEO_DECODERS: LazyLock<Mutex<Vec<(VideoDecoderType, VideoDecoder)>>> =
+    LazyLock::new(Default::default);
+
+/// Opens a video encoder for the given settings and parks it in the pool, so
+/// a later acquire with the same settings returns instantly. Call this at
+/// process start for the settings the application usually casts with.
+pub fn prewarm_video_encoder(settings: VideoEncoderSettings) -> Result<(), VideoEncoderError> {
+    let key = encoder_key(&settings);
+    let encoder = VideoEncoder::new(settings)?;
+
+    let mut encoders = VIDEO_ENCODERS.lock().unwrap();
+    if encoders.len() < MAX_IDLE {
+        encoders.push((key, encoder));
+    }
+
+    Ok(())
+}
+
+/// Opens a video decoder for the given settings and parks it in the pool.
+pub fn prewarm_video_decoder(settings: VideoDecoderSettings) -> Result<(), VideoDecoderError> {
+    let codec = settings.codec;
+    let decoder = VideoDecoder::new(settings)?;
+
+    let mut decoders = VIDEO_DECODERS.lock().unwrap();
+    if decoders.len() < MAX_IDLE {
+        decoders.push((codec, decoder));
+    }
+
+    Ok(())
+}
+
+/// Takes a matching encoder out of the pool, falling back to a regular open
+/// when nothing matches. The recycled context is flushed and retuned to the
+/// requested bitrate before it is handed out.
+pub fn acquire_video_encoder(
+    settings: VideoEncoderSettings,
+) -> Result<VideoEncoder, VideoEncoderError> {
+    let key = encoder_key(&settings);
+
+    {
+        let mut encoders = VIDEO_ENCODERS.lock().unwrap();
+        if let Some(index) = encoders.iter().position(|(it, _)| it == &key) {
+            let (_, mut encoder) = encoders.swap_remove(index);
+            drop(encoders);
+
+            encoder.reset();
+            encoder.set_bit_rate(settings.bit_rate);
+
+            return Ok(encoder);
+        }
+    }
+
+    VideoEncoder::new(settings)
+}
+
+/// Takes a matching decoder out of the pool, falling back to a regular open
+/// when nothing matches.
+pub fn acquire_video_decoder(
+    settings: VideoDecoderSettings,
+) -> Result<VideoDecoder, VideoDecoderError> {
+    {
+        let mut decoders = VIDEO_DECODERS.lock().unwrap();
+        if let Some(index) = decoders.iter().position(|(it, _)| it == &settings.codec) {
+            let (_, mut decoder) = decoders.swap_remove(index);
+            drop(decoders);
+
+            if decoder.reset() {
+                return Ok(decoder);
+            }
+        }
+    }
+
+    VideoDecoder::new(settings)
+}
+
+/// Returns a session's encoder to the pool for the next sender with the same
+/// settings. Dropped instead when the pool is full.
+pub fn release_video_encoder(settings: &VideoEncoderSettings, encoder: VideoEncoder) {
+    let mut encoders = VIDEO_ENCODERS.lock().unwrap();
+    if encoders.len() < MAX_IDLE {
+        encoders.push((encoder_key(settings), encoder));
+    }
+}
+
+/// Returns a session's decoder to the pool for the next receiver with the
+/// same codec. Dropped instead when the pool is full.
+pub fn release_video_decoder(settings: &VideoDecoderSettings, decoder: VideoDecoder) {
+    let mut decoders = VIDEO_DECODERS.lock().unwrap();
+    if decoders.len() < MAX_IDLE {
+        decoders.push((settings.codec, decoder));
+    }
+}
@@ -11,7 +11,7 @@ use common::{
 use ffmpeg::*;
 use thiserror::Error;
 
-#[cfg(any(target_os = "windows", target_os = "macos"))]
+#[cfg(any(target_os = "windows", target_os = "macos", target_os = "linux"))]
 use common::Size;
 
 #[cfg(target_os = "windows")]
@@ -20,6 +20,9 @@ use common::win32::{Direct3DDevice, windows::core::Interface};
 #[cfg(target_os = "macos")]
 use common::macos::get_pixel_buffer_format;
 
+#[cfg(target_os = "linux")]
+use common::frame::DmaBufDescriptor;
+
 #[derive(Error, Debug)]
 pub enum VideoDecoderError {
     #[error(transparent)]
@@ -48,6 +51,12 @@ pub struct VideoDecoder {
     packet: *mut AVPacket,
     av_frame: *mut AVFrame,
     frame: VideoFrame,
+    // The drm prime mapping of the current vaapi frame, it borrows the vaapi
+    // surface and is kept alive until the next frame replaces it.
+    #[cfg(target_os = "linux")]
+    drm_frame: *mut AVFrame,
+    #[cfg(target_os = "linux")]
+    dmabuf: DmaBufDescriptor,
 }
 
 unsafe impl Sync for VideoDecoder {}
@@ -65,6 +74,10 @@ impl VideoDecoder {
             packet: null_mut(),
             av_frame: null_mut(),
             frame: VideoFrame::default(),
+            #[cfg(target_os = "linux")]
+            drm_frame: null_mut(),
+            #[cfg(target_os = "linux")]
+            dmabuf: DmaBufDescriptor::default(),
         };
 
         #[cfg(target_os = "windows")]
@@ -76,7 +89,7 @@ impl VideoDecoder {
         )?;
 
         #[cfg(target_os = "linux")]
-        let codec = create_video_context(&mut this.context, CodecType::from(options.codec))?;
+        let codec = create_video_context(&mut this.context, CodecType::from(options.codec), None)?;
 
         #[cfg(target_os = "macos")]
         let codec = create_video_context(&mut this.context, CodecType::from(options.codec), None)?;
@@ -163,6 +176,17 @@ impl VideoDecoder {
         Ok(())
     }
 
+    // Flushes session state and restarts the bitstream parser so the context
+    // can be reused by the warm pool. Returns false if the parser could not
+    // be recreated, in which case the decoder must not be reused.
+    pub(crate) fn reset(&mut self) -> bool {
+        unsafe { avcodec_flush_buffers(self.context) };
+        unsafe { av_parser_close(self.parser) };
+
+        self.parser = unsafe { av_parser_init({ &*self.context }.codec_id as i32) };
+        !self.parser.is_null()
+    }
+
     pub fn read<'a>(&'a mut self) -> Option<&'a VideoFrame> {
         // When decoding, each video frame uses a newly created one.
         if !self.av_frame.is_null() {
@@ -228,6 +252,73 @@ impl VideoDecoder {
                 self.frame.sub_format = VideoSubFormat::SW;
                 self.frame.format = VideoFormat::I420;
             }
+            // The vaapi surface itself never leaves the gpu, instead it is
+            // exported as a drm prime (dmabuf) description that the renderer
+            // imports directly as an external texture. The mapping borrows
+            // the surface, so the mapped frame is kept alive until the next
+            // frame replaces it.
+            #[cfg(target_os = "linux")]
+            AVPixelFormat::AV_PIX_FMT_VAAPI => {
+                if !self.drm_frame.is_null() {
+                    unsafe {
+                        av_frame_free(&mut self.drm_frame);
+                    }
+                }
+
+                self.drm_frame = unsafe { av_frame_alloc() };
+                if self.drm_frame.is_null() {
+                    return None;
+                }
+
+                unsafe { &mut *self.drm_frame }.format = AVPixelFormat::AV_PIX_FMT_DRM_PRIME as i32;
+                if unsafe {
+                    av_hwframe_map(self.drm_frame, self.av_frame, AV_HWFRAME_MAP_READ as i32)
+                } != 0
+                {
+                    log::error!("failed to map vaapi frame to drm prime");
+
+                    return None;
+                }
+
+                let desc =
+                    unsafe { &*({ &*self.drm_frame }.data[0] as *const AVDRMFrameDescriptor) };
+
+                // Vaapi exports nv12 surfaces as a single kernel buffer, a
+                // disjoint layout would need one import per plane which
+                // nothing downstream supports.
+                if desc.nb_objects != 1 {
+                    log::error!(
+                        "unsupported multi object drm prime frame, objects={}",
+                        desc.nb_objects
+                    );
+
+                    return None;
+                }
+
+                self.dmabuf = DmaBufDescriptor {
+                    fd: desc.objects[0].fd,
+                    size: desc.objects[0].size,
+                    modifier: desc.objects[0].format_modifier,
+                    planes: 0,
+                    offset: [0; 3],
+                    pitch: [0; 3],
+                };
+
+                for layer in &desc.layers[..desc.nb_layers as usize] {
+                    for plane in &layer.planes[..layer.nb_planes as usize] {
+                        if self.dmabuf.planes < 3 {
+                            self.dmabuf.offset[self.dmabuf.planes] = plane.offset as u64;
+                            self.dmabuf.pitch[self.dmabuf.planes] = plane.pitch as u64;
+                            self.dmabuf.planes += 1;
+                        }
+                    }
+                }
+
+                self.frame.data[0] = &self.dmabuf as *const DmaBufDescriptor as *const _;
+
+                self.frame.sub_format = VideoSubFormat::DmaBuf;
+                self.frame.format = VideoFormat::NV12;
+            }
             #[cfg(target_os = "macos")]
             AVPixelFormat::AV_PIX_FMT_VIDEOTOOLBOX => {
                 self.frame.data[0] = frame.data[3] as _;
@@ -275,6 +366,15 @@ impl Drop for VideoDecoder {
             }
         }
 
+        // The mapping borrows the decoded surface, release it before the
+        // frame it was mapped from.
+        #[cfg(target_os = "linux")]
+        if !self.drm_frame.is_null() {
+            unsafe {
+                av_frame_free(&mut self.drm_frame);
+            }
+        }
+
         if !self.av_frame.is_null() {
             unsafe {
                 av_frame_free(&mut self.av_frame);
@@ -303,7 +403,12 @@ pub struct VideoEncoder {
     context: *mut AVCodecContext,
     packet: *mut AVPacket,
     frame: *mut AVFrame,
+    // Staging frame in system memory for encoders whose input frames live in
+    // gpu memory but whose capture source produces software frames, see the
+    // vaapi upload path in `update`.
+    sw_frame: *mut AVFrame,
     initialized: bool,
+    key_frame_requested: bool,
 }
 
 unsafe impl Sync for VideoEncoder {}
@@ -319,7 +424,9 @@ impl VideoEncoder {
             context: null_mut(),
             packet: null_mut(),
             frame: null_mut(),
+            sw_frame: null_mut(),
             initialized: false,
+            key_frame_requested: false,
         };
 
         #[cfg(target_os = "windows")]
@@ -334,7 +441,14 @@ impl VideoEncoder {
         )?;
 
         #[cfg(target_os = "linux")]
-        let codec = create_video_context(&mut this.context, CodecType::from(options.codec))?;
+        let codec = create_video_context(
+            &mut this.context,
+            CodecType::from(options.codec),
+            Some(Size {
+                width: options.width,
+                height: options.height,
+            }),
+        )?;
 
         #[cfg(target_os = "macos")]
         let codec = create_video_context(
@@ -360,9 +474,12 @@ impl VideoEncoder {
 
         // The QSV encoder can only use qsv frames. Although the internal structure is a
         // platform-specific hardware texture, you cannot directly tell qsv a specific
-        // format.
+        // format. The same goes for vaapi, which encodes from vaapi surfaces.
+        // NVENC and AMF take nv12 in system memory and upload internally.
         if options.codec == VideoEncoderType::Qsv {
             context_mut.pix_fmt = AVPixelFormat::AV_PIX_FMT_QSV;
+        } else if options.codec == VideoEncoderType::Vaapi {
+            context_mut.pix_fmt = AVPixelFormat::AV_PIX_FMT_VAAPI;
         } else {
             context_mut.thread_count = 4;
             context_mut.thread_type = FF_THREAD_SLICE as i32;
@@ -411,6 +528,20 @@ impl VideoEncoder {
                 set_option(context_mut, "realtime", 1);
                 set_option(context_mut, "coder", 1); // vlc
             }
+            VideoEncoderType::Nvenc => {
+                set_str_option(context_mut, "preset", "p1");
+                set_str_option(context_mut, "tune", "ull");
+                set_option(context_mut, "delay", 0);
+                set_option(context_mut, "zerolatency", 1);
+            }
+            VideoEncoderType::Vaapi => {
+                set_option(context_mut, "async_depth", 1);
+                set_option(context_mut, "low_power", 1);
+            }
+            VideoEncoderType::Amf => {
+                set_str_option(context_mut, "usage", "ultralowlatency");
+                set_str_option(context_mut, "rc", "cbr");
+            }
         };
 
         if unsafe { avcodec_open2(this.context, codec, null_mut()) } != 0 {
@@ -430,6 +561,29 @@ impl VideoEncoder {
         // then reused by replacing the data inside the frame.
         create_video_frame(&mut this.frame, this.context)?;
 
+        // The vaapi encoder consumes gpu surfaces but the capture pipeline
+        // hands over software frames, so a reusable nv12 staging frame is
+        // kept around and uploaded from on every encode.
+        if options.codec == VideoEncoderType::Vaapi {
+            this.sw_frame = unsafe { av_frame_alloc() };
+            if this.sw_frame.is_null() {
+                return Err(VideoEncoderError::CreateVideoFrameError(
+                    CreateVideoFrameError::AllocAVFrameError,
+                ));
+            }
+
+            let sw_frame_mut = unsafe { &mut *this.sw_frame };
+            sw_frame_mut.width = options.width as i32;
+            sw_frame_mut.height = options.height as i32;
+            sw_frame_mut.format = AVPixelFormat::AV_PIX_FMT_NV12 as i32;
+
+            if unsafe { av_frame_get_buffer(this.sw_frame, 0) } != 0 {
+                return Err(VideoEncoderError::CreateVideoFrameError(
+                    CreateVideoFrameError::AllocAVFrameBufferError,
+                ));
+            }
+        }
+
         Ok(this)
     }
 
@@ -463,6 +617,34 @@ impl VideoEncoder {
                 av_frame.data[3] = frame.data[0] as _;
             }
             VideoSubFormat::SW => {
+                // The encoder frame lives in gpu memory, copy into the
+                // software staging frame and upload it as a whole instead.
+                if !self.sw_frame.is_null() {
+                    if unsafe { av_frame_make_writable(self.sw_frame) } != 0 {
+                        return false;
+                    }
+
+                    let sw_frame = unsafe { &mut *self.sw_frame };
+                    unsafe {
+                        av_image_copy(
+                            sw_frame.data.as_mut_ptr(),
+                            sw_frame.linesize.as_mut_ptr(),
+                            frame.data.as_ptr() as _,
+                            [
+                                frame.linesize[0] as i32,
+                                frame.linesize[1] as i32,
+                                frame.linesize[2] as i32,
+                            ]
+                            .as_ptr(),
+                            AVPixelFormat::AV_PIX_FMT_NV12,
+                            sw_frame.width,
+                            sw_frame.height,
+                        );
+                    }
+
+                    return unsafe { av_hwframe_transfer_data(self.frame, self.sw_frame, 0) } == 0;
+                }
+
                 // Anyway, the hardware encoder has no way to check whether the current frame is
                 // writable.
                 if unsafe { av_frame_make_writable(self.frame) } != 0 {
@@ -497,6 +679,18 @@ impl VideoEncoder {
 
     pub fn encode(&mut self) -> Result<(), VideoEncoderError> {
         let av_frame = unsafe { &mut *self.frame };
+
+        // Forcing the picture type overrides the regular gop cadence for one
+        // frame, the encoder emits an IDR and then falls back to its own
+        // schedule.
+        av_frame.pict_type = if self.key_frame_requested {
+            self.key_frame_requested = false;
+
+            AVPictureType::AV_PICTURE_TYPE_I
+        } else {
+            AVPictureType::AV_PICTURE_TYPE_NONE
+        };
+
         av_frame.pts = unsafe {
             let context_ref = &*self.context;
             av_rescale_q(
@@ -554,6 +748,23 @@ impl VideoEncoder {
         unsafe { &*self.context }.bit_rate as u64
     }
 
+    // Flushes session state so the context can be reused by the warm pool.
+    // The next read() emits the extradata configuration again, exactly like a
+    // freshly opened encoder.
+    pub(crate) fn reset(&mut self) {
+        unsafe { avcodec_flush_buffers(self.context) };
+
+        self.initialized = false;
+        self.key_frame_requested = false;
+    }
+
+    /// Ask the encoder to emit a key frame on the next encode call, used to
+    /// resynchronize the stream after heavy loss or when a receiver joins
+    /// mid-stream.
+    pub fn request_key_frame(&mut self) {
+        self.key_frame_requested = true;
+    }
+
     pub fn set_bit_rate(&mut self, bit_rate: u64) {
         let context_mut = unsafe { &mut *self.context };
 
@@ -596,6 +807,12 @@ impl Drop for VideoEncoder {
                 av_frame_free(&mut self.frame);
             }
         }
+
+        if !self.sw_frame.is_null() {
+            unsafe {
+                av_frame_free(&mut self.sw_frame);
+            }
+        }
     }
 }
 
@@ -651,18 +868,27 @@ impl CodecType {
         match self {
             CodecType::Encoder(kind) => {
                 if cfg!(target_os = "windows") {
-                    *kind != VideoEncoderType::VideoToolBox
+                    !matches!(
+                        kind,
+                        VideoEncoderType::VideoToolBox | VideoEncoderType::Vaapi
+                    )
                 } else if cfg!(target_os = "linux") {
-                    *kind == VideoEncoderType::X265
+                    matches!(
+                        kind,
+                        VideoEncoderType::X265 | VideoEncoderType::Nvenc | VideoEncoderType::Vaapi
+                    )
                 } else {
                     *kind == VideoEncoderType::X265 || *kind == VideoEncoderType::VideoToolBox
                 }
             }
             CodecType::Decoder(kind) => {
                 if cfg!(target_os = "windows") {
-                    *kind != VideoDecoderType::VideoToolBox
+                    !matches!(
+                        kind,
+                        VideoDecoderType::VideoToolBox | VideoDecoderType::Vaapi
+                    )
                 } else if cfg!(target_os = "linux") {
-                    *kind == VideoDecoderType::HEVC
+                    matches!(kind, VideoDecoderType::HEVC | VideoDecoderType::Vaapi)
                 } else {
                     *kind == VideoDecoderType::HEVC || *kind == VideoDecoderType::VideoToolBox
                 }
@@ -685,10 +911,25 @@ impl CodecType {
         }
     }
 
+    pub fn is_vaapi(self) -> bool {
+        match self {
+            CodecType::Encoder(kind) => kind == VideoEncoderType::Vaapi,
+            CodecType::Decoder(kind) => kind == VideoDecoderType::Vaapi,
+        }
+    }
+
+    /// Whether the codec works on hardware textures. NVENC and AMF encode on
+    /// the GPU too, but they take nv12 frames in system memory and upload
+    /// internally, so for the capture pipeline they count as software inputs.
     pub fn is_hardware(&self) -> bool {
         match self {
             Self::Decoder(codec) => *codec != VideoDecoderType::HEVC,
-            Self::Encoder(codec) => *codec != VideoEncoderType::X265,
+            Self::Encoder(codec) => {
+                matches!(
+                    codec,
+                    VideoEncoderType::Qsv | VideoEncoderType::VideoToolBox
+                )
+            }
         }
     }
 
@@ -698,7 +939,15 @@ impl CodecType {
                 avcodec_find_encoder_by_name(PSTR::from(kind.to_string()).as_ptr())
             },
             Self::Decoder(kind) => {
-                if *kind == VideoDecoderType::D3D11 || *kind == VideoDecoderType::VideoToolBox {
+                // d3d11va, videotoolbox and vaapi are hardware accelerations
+                // of the stock hevc decoder rather than decoders of their
+                // own, they cannot be found by name.
+                if matches!(
+                    kind,
+                    VideoDecoderType::D3D11
+                        | VideoDecoderType::VideoToolBox
+                        | VideoDecoderType::Vaapi
+                ) {
                     unsafe { avcodec_find_decoder(AVCodecID::AV_CODEC_ID_HEVC) }
                 } else {
                     unsafe { avcodec_find_decoder_by_name(PSTR::from(kind.to_string()).as_ptr()) }
@@ -826,6 +1075,7 @@ pub fn create_video_context(
 pub fn create_video_context(
     context: &mut *mut AVCodecContext,
     kind: CodecType,
+    size: Option<Size>,
 ) -> Result<*const AVCodec, CreateVideoContextError> {
     let codec = unsafe { kind.find_av_codec() };
     if codec.is_null() {
@@ -837,6 +1087,55 @@ pub fn create_video_context(
         return Err(CreateVideoContextError::AllocAVContextError);
     }
 
+    // vaapi is the only linux backend that works on gpu surfaces, nvenc and
+    // the software encoders take system memory frames directly. Let ffmpeg
+    // open the default drm render node itself.
+    if kind.is_vaapi() {
+        let mut hw_device_ctx = std::ptr::null_mut();
+        if unsafe {
+            av_hwdevice_ctx_create(
+                &mut hw_device_ctx,
+                AVHWDeviceType::AV_HWDEVICE_TYPE_VAAPI,
+                std::ptr::null_mut(),
+                std::ptr::null_mut(),
+                0,
+            )
+        } != 0
+        {
+            return Err(CreateVideoContextError::InitAVHardwareDeviceContextError);
+        }
+
+        let context_mut = unsafe { &mut **context };
+        context_mut.hw_device_ctx = unsafe { av_buffer_ref(hw_device_ctx) };
+
+        // The encoder consumes vaapi surfaces, so it needs a hardware frame
+        // pool the staged uploads are transferred into.
+        if kind.is_encoder() {
+            let hw_frames_ctx = unsafe { av_hwframe_ctx_alloc(context_mut.hw_device_ctx) };
+            if hw_frames_ctx.is_null() {
+                return Err(CreateVideoContextError::AllocAVHardwareFrameContextError);
+            }
+
+            let size = size.expect("encoder needs init hardware frame for size");
+            unsafe {
+                let frames_ctx = &mut *((&mut *hw_frames_ctx).data as *mut AVHWFramesContext);
+                frames_ctx.sw_format = AVPixelFormat::AV_PIX_FMT_NV12;
+                frames_ctx.format = AVPixelFormat::AV_PIX_FMT_VAAPI;
+                frames_ctx.width = size.width as i32;
+                frames_ctx.height = size.height as i32;
+                frames_ctx.initial_pool_size = 5;
+            }
+
+            if unsafe { av_hwframe_ctx_init(hw_frames_ctx) } != 0 {
+                return Err(CreateVideoContextError::InitAVHardwareFrameContextError);
+            }
+
+            unsafe {
+                context_mut.hw_frames_ctx = av_buffer_ref(hw_frames_ctx);
+            }
+        }
+    }
+
     Ok(codec)
 }
 
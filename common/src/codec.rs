@@ -28,6 +28,11 @@ pub enum VideoDecoderType {
     /// VideoToolbox is a low-level framework that provides direct access to
     /// hardware encoders and decoders.
     VideoToolBox,
+    /// [VAAPI](https://intel.github.io/libva/)
+    ///
+    /// Accelerated video decoding on linux via the Video Acceleration API,
+    /// decoded surfaces stay in gpu memory and are exported as dmabuf.
+    Vaapi,
 }
 
 impl ToString for VideoDecoderType {
@@ -37,6 +42,7 @@ impl ToString for VideoDecoderType {
             Self::D3D11 => "d3d11va",
             Self::Qsv => "hevc_qsv",
             Self::VideoToolBox => "hevc_videotoolbox",
+            Self::Vaapi => "hevc_vaapi",
         }
         .to_string()
     }
@@ -51,6 +57,7 @@ impl FromStr for VideoDecoderType {
             "d3d11va" => Self::D3D11,
             "hevc_qsv" => Self::Qsv,
             "hevc_videotoolbox" => Self::VideoToolBox,
+            "hevc_vaapi" => Self::Vaapi,
             _ => return Err(Error::new(ErrorKind::InvalidInput, value)),
         })
     }
@@ -76,6 +83,21 @@ pub enum VideoEncoderType {
     /// VideoToolbox is a low-level framework that provides direct access to
     /// hardware encoders and decoders.
     VideoToolBox,
+    /// [NVENC](https://developer.nvidia.com/video-codec-sdk)
+    ///
+    /// NVENC is the dedicated video encoding hardware block on NVIDIA GPUs,
+    /// encoding is fully offloaded from the CPU.
+    Nvenc,
+    /// [VA-API](https://intel.github.io/libva/)
+    ///
+    /// The Video Acceleration API is the standard hardware video acceleration
+    /// interface on Linux, backed by the GPU driver.
+    Vaapi,
+    /// [AMF](https://gpuopen.com/advanced-media-framework/)
+    ///
+    /// The Advanced Media Framework exposes the hardware video encoder on AMD
+    /// GPUs.
+    Amf,
 }
 
 impl ToString for VideoEncoderType {
@@ -84,6 +106,9 @@ impl ToString for VideoEncoderType {
             Self::X265 => "libx265",
             Self::Qsv => "hevc_qsv",
             Self::VideoToolBox => "hevc_videotoolbox",
+            Self::Nvenc => "hevc_nvenc",
+            Self::Vaapi => "hevc_vaapi",
+            Self::Amf => "hevc_amf",
         }
         .to_string()
     }
@@ -97,6 +122,9 @@ impl FromStr for VideoEncoderType {
             "libx265" => Self::X265,
             "hevc_qsv" => Self::Qsv,
             "hevc_videotoolbox" => Self::VideoToolBox,
+            "hevc_nvenc" => Self::Nvenc,
+            "hevc_vaapi" => Self::Vaapi,
+            "hevc_amf" => Self::Amf,
             _ => return Err(Error::new(ErrorKind::InvalidInput, value)),
         })
     }
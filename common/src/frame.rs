@@ -51,7 +51,14 @@
 //! JPEG: it has BT.601 matrix derived from System M primaries, yet the
 //! primaries of most images are BT.709.
 
-use std::{ffi::c_void, ptr::null};
+use std::{
+    ffi::c_void,
+    mem,
+    ptr::null,
+    sync::{Arc, Weak},
+};
+
+use parking_lot::Mutex;
 
 #[cfg(feature = "serde")]
 use serde_repr::{Deserialize_repr, Serialize_repr};
@@ -101,11 +108,38 @@ pub enum VideoSubFormat {
     CvPixelBufferRef,
     /// Inside this video frame is ID3D11Texture2D.
     D3D11,
+    /// This video frame is a linux dmabuf, `data[0]` points to a
+    /// [`DmaBufDescriptor`].
+    DmaBuf,
     /// Video frames contain buffers that can be accessed directly through
     /// software.
     SW,
 }
 
+/// Description of a video frame exported as a linux dmabuf.
+///
+/// This mirrors the single object layout produced by mapping a vaapi surface
+/// to drm prime: all planes live in one kernel buffer referenced by `fd`,
+/// each at its own offset and pitch. The file descriptor is owned by the
+/// producer of the frame and stays valid only as long as the frame itself,
+/// importers that keep the buffer longer must `dup` it first.
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy)]
+pub struct DmaBufDescriptor {
+    /// The dmabuf file descriptor.
+    pub fd: i32,
+    /// Total size of the buffer behind `fd` in bytes.
+    pub size: usize,
+    /// The drm format modifier describing the buffer layout.
+    pub modifier: u64,
+    /// Number of used entries in `offset` and `pitch`.
+    pub planes: usize,
+    /// Byte offset of each plane inside the buffer.
+    pub offset: [u64; 3],
+    /// Row pitch of each plane in bytes.
+    pub pitch: [u64; 3],
+}
+
 /// A frame in a video stream.
 #[repr(C)]
 #[derive(Debug)]
@@ -136,3 +170,348 @@ impl Default for VideoFrame {
         }
     }
 }
+
+/// A software video frame copied into owned memory, so it can outlive the
+/// temporary [`VideoFrame`] reference it was created from and cross thread
+/// boundaries. The planes are laid out back to back in a single reusable
+/// allocation.
+pub struct OwnedVideoFrame {
+    pub format: VideoFormat,
+    pub width: u32,
+    pub height: u32,
+    pub linesize: [u32; 3],
+    /// Byte offset of each plane inside the buffer.
+    pub planes: [usize; 3],
+    pub buffer: Vec<u8>,
+}
+
+impl OwnedVideoFrame {
+    /// Copies a software frame into the given buffer, which is reused so a
+    /// recycled allocation makes the copy allocation free.
+    pub fn copy(frame: &VideoFrame, mut buffer: Vec<u8>) -> Self {
+        // Plane heights differ per format, the chroma planes of i420 are half
+        // height while nv12 interleaves both chroma components into a single
+        // full height plane.
+        let heights = match frame.format {
+            VideoFormat::BGRA | VideoFormat::RGBA => [frame.height as usize, 0, 0],
+            VideoFormat::NV12 => [frame.height as usize, frame.height as usize, 0],
+            VideoFormat::I420 => [
+                frame.height as usize,
+                frame.height as usize / 2,
+                frame.height as usize / 2,
+            ],
+        };
+
+        buffer.clear();
+
+        let mut planes = [0; 3];
+        for i in 0..3 {
+            planes[i] = buffer.len();
+
+            if heights[i] > 0 {
+                buffer.extend_from_slice(unsafe {
+                    std::slice::from_raw_parts(
+                        frame.data[i] as *const u8,
+                        frame.linesize[i] as usize * heights[i],
+                    )
+                });
+            }
+        }
+
+        Self {
+            format: frame.format,
+            width: frame.width,
+            height: frame.height,
+            linesize: frame.linesize,
+            planes,
+            buffer,
+        }
+    }
+
+    /// A borrowed view of this frame, the plane pointers stay valid for as
+    /// long as the owned frame is alive.
+    pub fn as_frame(&self) -> VideoFrame {
+        let mut data: [*const c_void; 3] = [null(), null(), null()];
+        for i in 0..3 {
+            data[i] = unsafe { self.buffer.as_ptr().add(self.planes[i]) } as *const _;
+        }
+
+        VideoFrame {
+            format: self.format,
+            sub_format: VideoSubFormat::SW,
+            width: self.width,
+            height: self.height,
+            linesize: self.linesize,
+            data,
+        }
+    }
+}
+
+/// A recycling pool of owned video frames.
+///
+/// Frames acquired through [`VideoFramePool::copy`] are reference counted,
+/// clones share the same storage, and the backing allocation goes back to
+/// the pool on the last drop. A pipeline stage that needs to hold a frame
+/// past the capture callback clones the handle instead of copying planes,
+/// so in steady state the only copy is the one out of the capture buffer
+/// and nothing allocates.
+#[derive(Default, Clone)]
+pub struct VideoFramePool {
+    buffers: Arc<Mutex<Vec<Vec<u8>>>>,
+}
+
+impl VideoFramePool {
+    // More recycled buffers than stages that can hold a frame at once just
+    // pin memory, anything beyond this is dropped for real.
+    const MAX_IDLE: usize = 8;
+
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Copies a borrowed software frame into a pooled frame, reusing a
+    /// recycled allocation when one is available.
+    pub fn copy(&self, frame: &VideoFrame) -> PooledVideoFrame {
+        let buffer = self.buffers.lock().pop().unwrap_or_default();
+
+        PooledVideoFrame(Arc::new(PooledFrameStorage {
+            frame: OwnedVideoFrame::copy(frame, buffer),
+            pool: Arc::downgrade(&self.buffers),
+        }))
+    }
+}
+
+// The storage shared by all clones of a pooled frame, its drop is the last
+// drop of the frame and hands the allocation back to the pool.
+struct PooledFrameStorage {
+    frame: OwnedVideoFrame,
+    pool: Weak<Mutex<Vec<Vec<u8>>>>,
+}
+
+impl Drop for PooledFrameStorage {
+    fn drop(&mut self) {
+        if let Some(pool) = self.pool.upgrade() {
+            let mut buffers = pool.lock();
+            if buffers.len() < VideoFramePool::MAX_IDLE {
+                buffers.push(mem::take(&mut self.frame.buffer));
+            }
+        }
+    }
+}
+
+/// A reference counted frame from a [`VideoFramePool`].
+///
+/// Clones are pointer copies sharing the same planes, so the frame moves
+/// between threads without its pixels moving.
+#[derive(Clone)]
+pub struct PooledVideoFrame(Arc<PooledFrameStorage>);
+
+impl PooledVideoFrame {
+    /// A borrowed view of this frame, the plane pointers stay valid for as
+    /// long as any clone of the handle is alive.
+    pub fn as_frame(&self) -> VideoFrame {
+        self.0.frame.as_frame()
+    }
+}
+
+/// Interleaves separate u and v chroma planes into the packed uv plane of an
+/// nv12 frame.
+///
+/// This is the hot loop of every i420 to nv12 conversion that runs on the
+/// cpu, e.g. when the hardware video processor is fed software frames. The
+/// scalar version moves one byte per iteration, the simd kernels move a
+/// cache line per iteration, so the conversion stops showing up in profiles
+/// on non-hardware boxes. The kernel is picked at runtime from what the cpu
+/// actually supports.
+///
+/// `uv` must be at least twice as long as the shorter of `u` and `v`.
+pub fn interleave_uv(u: &[u8], v: &[u8], uv: &mut [u8]) {
+    let size = u.len().min(v.len()).min(uv.len() / 2);
+
+    #[cfg(target_arch = "x86_64")]
+    if std::arch::is_x86_feature_detected!("avx2") {
+        return unsafe { simd::interleave_uv_avx2(&u[..size], &v[..size], &mut uv[..size * 2]) };
+    }
+
+    #[cfg(target_arch = "aarch64")]
+    {
+        // neon is part of the baseline aarch64 profile, no detection needed.
+        return unsafe { simd::interleave_uv_neon(&u[..size], &v[..size], &mut uv[..size * 2]) };
+    }
+
+    #[allow(unreachable_code)]
+    for i in 0..size {
+        uv[i * 2] = u[i];
+        uv[i * 2 + 1] = v[i];
+    }
+}
+
+/// Splits the packed uv plane of an nv12 frame into separate u and v planes,
+/// the inverse of [`interleave_uv`], for consumers that want i420 chroma.
+///
+/// `uv` must be at least twice as long as the shorter of `u` and `v`.
+pub fn deinterleave_uv(uv: &[u8], u: &mut [u8], v: &mut [u8]) {
+    let size = u.len().min(v.len()).min(uv.len() / 2);
+
+    #[cfg(target_arch = "x86_64")]
+    if std::arch::is_x86_feature_detected!("avx2") {
+        return unsafe {
+            simd::deinterleave_uv_avx2(&uv[..size * 2], &mut u[..size], &mut v[..size])
+        };
+    }
+
+    #[cfg(target_arch = "aarch64")]
+    {
+        return unsafe {
+            simd::deinterleave_uv_neon(&uv[..size * 2], &mut u[..size], &mut v[..size])
+        };
+    }
+
+    #[allow(unreachable_code)]
+    for i in 0..size {
+        u[i] = uv[i * 2];
+        v[i] = uv[i * 2 + 1];
+    }
+}
+
+#[cfg(any(target_arch = "x86_64", target_arch = "aarch64"))]
+mod simd {
+    #[cfg(target_arch = "x86_64")]
+    use std::arch::x86_64::*;
+
+    #[cfg(target_arch = "aarch64")]
+    use std::arch::aarch64::*;
+
+    #[cfg(target_arch = "x86_64")]
+    #[target_feature(enable = "avx2")]
+    pub(super) unsafe fn interleave_uv_avx2(u: &[u8], v: &[u8], uv: &mut [u8]) {
+        let size = u.len();
+        let mut i = 0;
+
+        // 32 bytes of each plane per iteration. The byte-wise unpack works
+        // inside each 128-bit lane, the cross-lane permute afterwards puts
+        // the halves back into memory order.
+        while i + 32 <= size {
+            unsafe {
+                let a = _mm256_loadu_si256(u.as_ptr().add(i) as *const _);
+                let b = _mm256_loadu_si256(v.as_ptr().add(i) as *const _);
+
+                let lo = _mm256_unpacklo_epi8(a, b);
+                let hi = _mm256_unpackhi_epi8(a, b);
+
+                _mm256_storeu_si256(
+                    uv.as_mut_ptr().add(i * 2) as *mut _,
+                    _mm256_permute2x128_si256(lo, hi, 0x20),
+                );
+
+                _mm256_storeu_si256(
+                    uv.as_mut_ptr().add(i * 2 + 32) as *mut _,
+                    _mm256_permute2x128_si256(lo, hi, 0x31),
+                );
+            }
+
+            i += 32;
+        }
+
+        for i in i..size {
+            uv[i * 2] = u[i];
+            uv[i * 2 + 1] = v[i];
+        }
+    }
+
+    #[cfg(target_arch = "x86_64")]
+    #[target_feature(enable = "avx2")]
+    pub(super) unsafe fn deinterleave_uv_avx2(uv: &[u8], u: &mut [u8], v: &mut [u8]) {
+        let size = u.len();
+        let mut i = 0;
+
+        while i + 32 <= size {
+            unsafe {
+                // Gathers the even bytes into the low and the odd bytes into
+                // the high half of every 128-bit lane.
+                let mask = _mm256_setr_epi8(
+                    0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15, 0, 2, 4, 6, 8, 10, 12,
+                    14, 1, 3, 5, 7, 9, 11, 13, 15,
+                );
+
+                let a = _mm256_shuffle_epi8(
+                    _mm256_loadu_si256(uv.as_ptr().add(i * 2) as *const _),
+                    mask,
+                );
+                let b = _mm256_shuffle_epi8(
+                    _mm256_loadu_si256(uv.as_ptr().add(i * 2 + 32) as *const _),
+                    mask,
+                );
+
+                // Sorts the per-lane halves into whole u and v registers.
+                let a = _mm256_permute4x64_epi64(a, 0b11011000);
+                let b = _mm256_permute4x64_epi64(b, 0b11011000);
+
+                _mm256_storeu_si256(
+                    u.as_mut_ptr().add(i) as *mut _,
+                    _mm256_permute2x128_si256(a, b, 0x20),
+                );
+
+                _mm256_storeu_si256(
+                    v.as_mut_ptr().add(i) as *mut _,
+                    _mm256_permute2x128_si256(a, b, 0x31),
+                );
+            }
+
+            i += 32;
+        }
+
+        for i in i..size {
+            u[i] = uv[i * 2];
+            v[i] = uv[i * 2 + 1];
+        }
+    }
+
+    #[cfg(target_arch = "aarch64")]
+    #[target_feature(enable = "neon")]
+    pub(super) unsafe fn interleave_uv_neon(u: &[u8], v: &[u8], uv: &mut [u8]) {
+        let size = u.len();
+        let mut i = 0;
+
+        // The two-register store interleaves for free.
+        while i + 16 <= size {
+            unsafe {
+                let a = vld1q_u8(u.as_ptr().add(i));
+                let b = vld1q_u8(v.as_ptr().add(i));
+
+                vst2q_u8(uv.as_mut_ptr().add(i * 2), uint8x16x2_t(a, b));
+            }
+
+            i += 16;
+        }
+
+        for i in i..size {
+            uv[i * 2] = u[i];
+            uv[i * 2 + 1] = v[i];
+        }
+    }
+
+    #[cfg(target_arch = "aarch64")]
+    #[target_feature(enable = "neon")]
+    pub(super) unsafe fn deinterleave_uv_neon(uv: &[u8], u: &mut [u8], v: &mut [u8]) {
+        let size = u.len();
+        let mut i = 0;
+
+        // The two-register load deinterleaves for free.
+        while i + 16 <= size {
+            unsafe {
+                let uint8x16x2_t(a, b) = vld2q_u8(uv.as_ptr().add(i * 2));
+
+                vst1q_u8(u.as_mut_ptr().add(i), a);
+                vst1q_u8(v.as_mut_ptr().add(i), b);
+            }
+
+            i += 16;
+        }
+
+        for i in i..size {
+            u[i] = uv[i * 2];
+            v[i] = uv[i * 2 + 1];
+        }
+    }
+}
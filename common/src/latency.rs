@@ -0,0 +1,99 @@
+//! Lightweight per-stage latency tracking for the media pipeline.
+//!
+//! Each pipeline stage records how long it spent on a frame into a
+//! [`LatencyHistogram`], and a snapshot with the median and tail quantiles
+//! can be taken at any time without stopping the stream. Recording is a
+//! single relaxed atomic increment, cheap enough to stay enabled in
+//! production, which is the whole point: when playback feels laggy the
+//! offending stage can be read off a running session instead of a custom
+//! instrumented build.
+//!
+//! The histograms are per process. The sender and receiver clocks are not
+//! synchronized, so time on the wire is not a stage here, it is the
+//! remainder after the local stages and is bounded by the round-trip time
+//! the transport statistics already report.
+
+use std::{
+    sync::atomic::{AtomicU64, Ordering},
+    time::Duration,
+};
+
+/// Median and tail latency of one pipeline stage, see
+/// [`LatencyHistogram::snapshot`].
+#[derive(Debug, Default, Clone, Copy)]
+pub struct LatencySnapshot {
+    /// Number of recorded durations.
+    pub count: u64,
+    /// Median duration.
+    pub p50: Duration,
+    /// 99th percentile duration.
+    pub p99: Duration,
+}
+
+/// A fixed size histogram of durations with logarithmic buckets.
+///
+/// Bucket widths double starting at one microsecond, so the quantiles are
+/// accurate to within a factor of two over a range from microseconds to
+/// minutes, which is plenty to tell a 2ms stage from a 40ms one. Recording
+/// never allocates and never takes a lock.
+pub struct LatencyHistogram {
+    buckets: [AtomicU64; Self::BUCKETS],
+}
+
+impl Default for LatencyHistogram {
+    fn default() -> Self {
+        Self {
+            buckets: std::array::from_fn(|_| AtomicU64::new(0)),
+        }
+    }
+}
+
+impl LatencyHistogram {
+    // Bucket i holds durations in [2^(i-1), 2^i) microseconds, the last
+    // bucket catches everything beyond ~35 minutes.
+    const BUCKETS: usize = 32;
+
+    /// Record one duration.
+    pub fn record(&self, elapsed: Duration) {
+        let us = elapsed.as_micros() as u64;
+        let index = ((64 - us.leading_zeros()) as usize).min(Self::BUCKETS - 1);
+
+        self.buckets[index].fetch_add(1, Ordering::Relaxed);
+    }
+
+    /// Take a snapshot of the current quantiles.
+    ///
+    /// The counters keep accumulating, so consecutive snapshots describe
+    /// the whole session up to that point.
+    pub fn snapshot(&self) -> LatencySnapshot {
+        let buckets: [u64; Self::BUCKETS] =
+            std::array::from_fn(|i| self.buckets[i].load(Ordering::Relaxed));
+
+        let count: u64 = buckets.iter().sum();
+        LatencySnapshot {
+            count,
+            p50: quantile(&buckets, count, 50),
+            p99: quantile(&buckets, count, 99),
+        }
+    }
+}
+
+// Walks the buckets until the requested share of the recordings is covered
+// and reports the upper bound of the bucket it landed in.
+fn quantile(buckets: &[u64], count: u64, percent: u64) -> Duration {
+    if count == 0 {
+        return Duration::ZERO;
+    }
+
+    let target = (count * percent).div_ceil(100);
+    let mut seen = 0;
+
+    for (index, it) in buckets.iter().enumerate() {
+        seen += it;
+        if seen >= target {
+            return Duration::from_micros(1 << index);
+        }
+    }
+
+    Duration::ZERO
+}
@@ -1,7 +1,10 @@
 pub mod codec;
 pub mod frame;
+pub mod latency;
 pub mod logger;
+pub mod metrics;
 pub mod runtime;
+pub mod scheduler;
 pub mod strings;
 
 #[cfg(target_os = "windows")]
@@ -15,7 +18,7 @@ use frame::VideoFormat;
 #[cfg(feature = "serde")]
 use serde::{Deserialize, Serialize};
 
-#[derive(Debug, Default, Clone, Copy)]
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
 #[cfg_attr(feature = "serde", derive(Deserialize, Serialize))]
 pub struct Size {
     pub width: u32,
@@ -42,6 +45,8 @@ pub struct MediaAudioStreamDescription {
 #[derive(Debug, Clone)]
 #[cfg_attr(feature = "serde", derive(Deserialize, Serialize))]
 pub struct MediaStreamDescription {
-    pub video: Option<MediaVideoStreamDescription>,
+    /// One entry per video track in track order, empty when the sender
+    /// captures no video.
+    pub videos: Vec<MediaVideoStreamDescription>,
     pub audio: Option<MediaAudioStreamDescription>,
 }
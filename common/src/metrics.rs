@@ -0,0 +1,46 @@
+//! Lock-free counters and gauges for session metrics.
+//!
+//! The hot paths update these with single relaxed atomic operations on
+//! values nothing contends on, so keeping them enabled costs nothing
+//! measurable and a snapshot is just a handful of relaxed loads. The
+//! snapshot structs built from them live next to the pipeline half they
+//! describe, this module only provides the primitives.
+
+use std::sync::atomic::{AtomicU64, Ordering};
+
+/// A monotonically increasing event counter.
+#[derive(Debug, Default)]
+pub struct Counter(AtomicU64);
+
+impl Counter {
+    /// Add to the counter.
+    pub fn add(&self, value: u64) {
+        self.0.fetch_add(value, Ordering::Relaxed);
+    }
+
+    /// Add one to the counter.
+    pub fn inc(&self) {
+        self.add(1);
+    }
+
+    /// Current value of the counter.
+    pub fn get(&self) -> u64 {
+        self.0.load(Ordering::Relaxed)
+    }
+}
+
+/// A value that goes up and down, e.g. a queue depth.
+#[derive(Debug, Default)]
+pub struct Gauge(AtomicU64);
+
+impl Gauge {
+    /// Overwrite the gauge with the current value.
+    pub fn set(&self, value: u64) {
+        self.0.store(value, Ordering::Relaxed);
+    }
+
+    /// Current value of the gauge.
+    pub fn get(&self) -> u64 {
+        self.0.load(Ordering::Relaxed)
+    }
+}
@@ -0,0 +1,158 @@
+//! Thread scheduling for the media pipeline.
+//!
+//! Every long-lived pipeline thread competes with whatever else runs on the
+//! host, and a capture or audio thread that loses its time slice shows up
+//! directly as a frame time spike on the far end. Each spawn site declares
+//! what its thread does through a [`PipelineRole`] and applies it from
+//! inside the new thread, so the whole pipeline carries one consistent
+//! priority plan instead of ad hoc per platform calls.
+
+use std::io::Error;
+
+/// What a pipeline thread does, which decides how aggressively the OS
+/// should schedule it.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum PipelineRole {
+    /// Pulls frames out of the OS capture APIs, a missed wakeup here is a
+    /// dropped or late frame that no later stage can recover.
+    Capture,
+    /// Moves or resamples PCM, the buffers are only tens of milliseconds
+    /// deep so preemption becomes audible quickly.
+    Audio,
+    /// Video encode and decode workers.
+    Encode,
+    /// Socket readers and writers of the transport layer.
+    Network,
+    /// Presents decoded frames.
+    Render,
+}
+
+impl PipelineRole {
+    /// Applies the role to the calling thread, call it first thing inside
+    /// the spawned closure.
+    ///
+    /// Elevation is best effort, realtime classes need privileges on most
+    /// systems and a refusal only costs the default priority, so failures
+    /// are logged and swallowed.
+    pub fn apply(self) {
+        if let Err(e) = set_current_thread_priority(self) {
+            log::warn!("failed to apply pipeline role={:?}, error={:?}", self, e);
+        }
+    }
+
+    // Capture and audio are time critical, everything else sits above the
+    // default priority but below them.
+    fn is_time_critical(self) -> bool {
+        matches!(self, Self::Capture | Self::Audio)
+    }
+}
+
+#[cfg(target_os = "windows")]
+fn set_current_thread_priority(role: PipelineRole) -> Result<(), Error> {
+    use windows::Win32::System::Threading::{
+        GetCurrentThread, SetThreadPriority, THREAD_PRIORITY_ABOVE_NORMAL,
+        THREAD_PRIORITY_TIME_CRITICAL,
+    };
+
+    unsafe {
+        SetThreadPriority(
+            GetCurrentThread(),
+            if role.is_time_critical() {
+                THREAD_PRIORITY_TIME_CRITICAL
+            } else {
+                THREAD_PRIORITY_ABOVE_NORMAL
+            },
+        )
+    }
+    .map_err(Error::other)
+}
+
+#[cfg(unix)]
+fn set_current_thread_priority(role: PipelineRole) -> Result<(), Error> {
+    // Round robin realtime scheduling needs privileges on most systems, so
+    // a refusal falls through to the nice based path below instead of
+    // failing the whole role.
+    if role.is_time_critical() {
+        let param = libc::sched_param {
+            sched_priority: unsafe {
+                (libc::sched_get_priority_min(libc::SCHED_RR)
+                    + libc::sched_get_priority_max(libc::SCHED_RR))
+                    / 2
+            },
+        };
+
+        if unsafe { libc::pthread_setschedparam(libc::pthread_self(), libc::SCHED_RR, &param) } == 0
+        {
+            return Ok(());
+        }
+    }
+
+    // On linux and android a thread is a task with its own nice value, so
+    // zero targets just the calling thread. On darwin this covers the whole
+    // process, which is still the right direction for a casting app.
+    if unsafe {
+        libc::setpriority(
+            libc::PRIO_PROCESS,
+            0,
+            if role.is_time_critical() { -15 } else { -5 },
+        )
+    } != 0
+    {
+        return Err(Error::last_os_error());
+    }
+
+    Ok(())
+}
+
+/// Pins the calling thread to the given cpu cores.
+///
+/// Optional, no pipeline thread pins itself. Applications that dedicate
+/// cores to capture or encode call this from a sink callback or their own
+/// threads, typically together with [`PipelineRole::apply`].
+#[cfg(target_os = "windows")]
+pub fn pin_current_thread(cores: &[usize]) -> Result<(), Error> {
+    use windows::Win32::System::Threading::{GetCurrentThread, SetThreadAffinityMask};
+
+    let mut mask = 0;
+    for core in cores {
+        mask |= 1 << core;
+    }
+
+    if unsafe { SetThreadAffinityMask(GetCurrentThread(), mask) } == 0 {
+        return Err(Error::last_os_error());
+    }
+
+    Ok(())
+}
+
+/// Pins the calling thread to the given cpu cores.
+///
+/// Optional, no pipeline thread pins itself. Applications that dedicate
+/// cores to capture or encode call this from a sink callback or their own
+/// threads, typically together with [`PipelineRole::apply`].
+#[cfg(any(target_os = "linux", target_os = "android"))]
+pub fn pin_current_thread(cores: &[usize]) -> Result<(), Error> {
+    unsafe {
+        let mut set: libc::cpu_set_t = std::mem::zeroed();
+        libc::CPU_ZERO(&mut set);
+        for core in cores {
+            libc::CPU_SET(*core, &mut set);
+        }
+
+        // A pid of zero targets the calling thread.
+        if libc::sched_setaffinity(0, std::mem::size_of::<libc::cpu_set_t>(), &set) != 0 {
+            return Err(Error::last_os_error());
+        }
+    }
+
+    Ok(())
+}
+
+/// Pins the calling thread to the given cpu cores.
+///
+/// Darwin has no public thread affinity API, the call is accepted and
+/// ignored so cross platform callers need no cfg of their own.
+#[cfg(target_os = "macos")]
+pub fn pin_current_thread(_cores: &[usize]) -> Result<(), Error> {
+    Ok(())
+}
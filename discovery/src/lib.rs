@@ -9,7 +9,13 @@ use std::{
     time::{Duration, Instant},
 };
 
-use axum::{Router, extract::State, http::StatusCode, response::IntoResponse, routing::get};
+use axum::{
+    Router,
+    extract::{Query, State},
+    http::StatusCode,
+    response::IntoResponse,
+    routing::get,
+};
 use serde::{Deserialize, Serialize};
 use tokio::{
     net::{TcpListener, UdpSocket},
@@ -45,10 +51,23 @@ pub trait DiscoveryObserver {
     }
 }
 
+/// A peer currently present in the discovery cache, see
+/// [`DiscoveryService::get_peers`].
+#[derive(Debug, Clone)]
+pub struct DiscoveryPeer {
+    pub id: String,
+    pub ip: IpAddr,
+    /// Version of the peer's metadata this service has last seen.
+    pub sequence: u32,
+}
+
 pub struct DiscoveryService {
     _t: Sender<()>,
-    metadata: Arc<RwLock<Option<Vec<u8>>>>,
+    metadata: Arc<RwLock<Option<(u32, Vec<u8>)>>>,
+    services: Arc<Mutex<HashMap<String, Service>>>,
     sequence: Arc<AtomicU32>,
+    socket: Arc<UdpSocket>,
+    to_addr: SocketAddr,
     local_id: String,
 }
 
@@ -60,7 +79,7 @@ impl DiscoveryService {
         let observer = Arc::new(observer);
         let local_id = Uuid::new_v4().to_string();
         let sequence: Arc<AtomicU32> = Default::default();
-        let metadata: Arc<RwLock<Option<Vec<u8>>>> = Default::default();
+        let metadata: Arc<RwLock<Option<(u32, Vec<u8>)>>> = Default::default();
         let service: Arc<Mutex<HashMap<String, Service>>> = Default::default();
 
         let (tx, mut rx) = channel::<()>(2);
@@ -77,9 +96,23 @@ impl DiscoveryService {
                 .route(
                     "/metadata",
                     get(
-                        |State(metadata): State<Arc<RwLock<Option<Vec<u8>>>>>| async move {
-                            if let Some(data) = metadata.read().await.as_ref() {
-                                data.clone().into_response()
+                        |State(metadata): State<Arc<RwLock<Option<(u32, Vec<u8>)>>>>,
+                         Query(query): Query<HashMap<String, String>>| async move {
+                            // A peer that already holds a version passes it
+                            // as `since` and gets an empty not-modified reply
+                            // instead of the whole blob when nothing changed.
+                            let since = query.get("since").and_then(|it| it.parse::<u32>().ok());
+
+                            if let Some((version, data)) = metadata.read().await.as_ref() {
+                                if since == Some(*version) {
+                                    StatusCode::NOT_MODIFIED.into_response()
+                                } else {
+                                    (
+                                        [(METADATA_VERSION_HEADER, version.to_string())],
+                                        data.clone(),
+                                    )
+                                        .into_response()
+                                }
                             } else {
                                 StatusCode::NOT_FOUND.into_response()
                             }
@@ -109,6 +142,7 @@ impl DiscoveryService {
         {
             let mut rx = tx.subscribe();
             let local_id = local_id.clone();
+            let sequence = sequence.clone();
             let services = service.clone();
             let socket = socket.clone();
             let observer = observer.clone();
@@ -131,7 +165,10 @@ impl DiscoveryService {
                                 let mut services = services.lock().await;
                                 if let Some(service) = services.get_mut(ping.id) {
                                     if service.sequence != ping.sequence {
-                                        if let Some(metadata) = request_metadata(addr.ip(), to_addr.port()).await {
+                                        // The known version rides along, so an
+                                        // unchanged blob costs a not-modified
+                                        // reply instead of a refetch.
+                                        if let Some(metadata) = request_metadata(addr.ip(), to_addr.port(), Some(service.sequence)).await {
                                             observer.on_metadata(&local_id, ping.id, addr.ip(), metadata).await;
                                         }
                                     }
@@ -145,8 +182,19 @@ impl DiscoveryService {
                                         ip: addr.ip(),
                                     });
 
+                                    // Answer a newcomer with an immediate
+                                    // unicast ping, its peer table fills in
+                                    // one round trip instead of waiting out
+                                    // everyone else's broadcast tick.
+                                    if let Err(e) = socket.send_to(&serde_json::to_vec(&Ping {
+                                        sequence: sequence.load(Ordering::Relaxed),
+                                        id: &local_id,
+                                    }).unwrap(), addr).await {
+                                        log::warn!("discovery service send pong failed, err={:?}", e);
+                                    }
+
                                     observer.online(&local_id, ping.id, addr.ip()).await;
-                                    if let Some(metadata) = request_metadata(addr.ip(), to_addr.port()).await {
+                                    if let Some(metadata) = request_metadata(addr.ip(), to_addr.port(), None).await {
                                         observer.on_metadata(&local_id, ping.id, addr.ip(), metadata).await;
                                     }
                                 }
@@ -167,7 +215,29 @@ impl DiscoveryService {
             let local_id = local_id.clone();
             let sequence = sequence.clone();
             let services = service.clone();
+            let socket = socket.clone();
             tokio::spawn(async move {
+                // A freshly started service announces itself with a short
+                // burst, a single lost datagram otherwise costs a full tick
+                // of invisibility on top of the scheduling delay.
+                for _ in 0..3 {
+                    if let Err(e) = socket
+                        .send_to(
+                            &serde_json::to_vec(&Ping {
+                                sequence: sequence.load(Ordering::Relaxed),
+                                id: &local_id,
+                            })
+                            .unwrap(),
+                            to_addr,
+                        )
+                        .await
+                    {
+                        log::error!("discovery service send ping failed, err={:?}", e);
+                    }
+
+                    sleep(Duration::from_millis(100)).await;
+                }
+
                 loop {
                     tokio::select! {
                         _ = sleep(Duration::from_secs(1)) => {
@@ -209,7 +279,10 @@ impl DiscoveryService {
         Ok(Self {
             _t: tx,
             metadata,
+            services: service,
             sequence,
+            socket,
+            to_addr,
             local_id,
         })
     }
@@ -218,14 +291,54 @@ impl DiscoveryService {
         &self.local_id
     }
 
+    /// Publish new metadata and announce it right away.
+    ///
+    /// The announcement does not wait for the next broadcast tick, every
+    /// peer sees the bumped version within a round trip and fetches the new
+    /// blob immediately.
     pub async fn set_metadata(&self, metadata: Vec<u8>) {
         log::info!("discovery service set metadata");
 
-        self.sequence.fetch_add(1, Ordering::Relaxed);
-        self.metadata.write().await.replace(metadata);
+        let version = self.sequence.fetch_add(1, Ordering::Relaxed) + 1;
+        self.metadata.write().await.replace((version, metadata));
+
+        if let Err(e) = self
+            .socket
+            .send_to(
+                &serde_json::to_vec(&Ping {
+                    sequence: version,
+                    id: &self.local_id,
+                })
+                .unwrap(),
+                self.to_addr,
+            )
+            .await
+        {
+            log::error!("discovery service send ping failed, err={:?}", e);
+        }
+    }
+
+    /// Snapshot of the peer cache, every service currently considered
+    /// online. The entries carry everything needed to start connecting to a
+    /// peer without waiting for another ping.
+    pub async fn get_peers(&self) -> Vec<DiscoveryPeer> {
+        self.services
+            .lock()
+            .await
+            .iter()
+            .map(|(id, it)| DiscoveryPeer {
+                id: id.clone(),
+                ip: it.ip,
+                sequence: it.sequence,
+            })
+            .collect()
     }
 }
 
+// Response header carrying the metadata version, mirrored back by peers as
+// the `since` query parameter.
+const METADATA_VERSION_HEADER: &str = "x-metadata-version";
+
 #[derive(Debug, Deserialize, Serialize)]
 struct Ping<'a> {
     id: &'a str,
@@ -238,11 +351,13 @@ struct Service {
     update_at: Instant,
 }
 
-async fn request_metadata(ip: IpAddr, port: u16) -> Option<Vec<u8>> {
-    let res = reqwest::get(format!("http://{}:{}/metadata", ip, port))
-        .await
-        .ok()?;
+async fn request_metadata(ip: IpAddr, port: u16, since: Option<u32>) -> Option<Vec<u8>> {
+    let mut url = format!("http://{}:{}/metadata", ip, port);
+    if let Some(since) = since {
+        url.push_str(&format!("?since={}", since));
+    }
 
+    let res = reqwest::get(url).await.ok()?;
     if res.status() != StatusCode::OK {
         return None;
     }
@@ -67,12 +67,12 @@ impl Sender {
         let video_options = CONFIG.get_video_options();
 
         // Get the first screen that can be captured.
-        let mut video = None;
+        let mut videos = Vec::new();
         if let Some(source) = Capture::get_sources(SourceType::Screen)?
             .iter()
             .find(|it| it.is_default)
         {
-            video = Some(HylaranaSenderTrackOptions {
+            videos.push(HylaranaSenderTrackOptions {
                 options: video_options.clone(),
                 source: source.clone(),
             });
@@ -94,7 +94,7 @@ impl Sender {
         }
 
         let options = HylaranaSenderOptions {
-            media: HylaranaSenderMediaOptions { video, audio },
+            media: HylaranaSenderMediaOptions { videos, audio },
             transport: TransportOptions::default(),
         };
 
@@ -322,7 +322,7 @@ impl Configure {
     const DEFAULT_DECODER: VideoDecoderType = VideoDecoderType::D3D11;
 
     #[cfg(target_os = "linux")]
-    const DEFAULT_DECODER: VideoDecoderType = VideoDecoderType::H264;
+    const DEFAULT_DECODER: VideoDecoderType = VideoDecoderType::Vaapi;
 
     fn get_video_options(&self) -> VideoOptions {
         VideoOptions {
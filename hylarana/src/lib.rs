@@ -1,5 +1,6 @@
 mod player;
 mod receiver;
+mod record;
 mod sender;
 mod util;
 
@@ -7,7 +8,7 @@ use std::net::SocketAddr;
 
 use thiserror::Error;
 
-pub use self::{player::*, receiver::*, sender::*};
+pub use self::{player::*, receiver::*, record::*, sender::*};
 
 pub use capture::{Capture, Source, SourceType};
 pub use common::{
@@ -15,8 +16,8 @@ pub use common::{
     codec::*, frame::*, runtime::*,
 };
 
-pub use discovery::{DiscoveryObserver, DiscoveryService};
-pub use renderer::{SurfaceTarget, raw_window_handle};
+pub use discovery::{DiscoveryObserver, DiscoveryPeer, DiscoveryService};
+pub use renderer::{RendererPresentMode, SurfaceTarget, raw_window_handle};
 pub use transport::TransportOptions;
 
 #[cfg(target_os = "windows")]
@@ -78,6 +79,26 @@ pub fn shutdown() -> Result<(), HylaranaError> {
     Ok(())
 }
 
+/// Pre-opens a video encoder context for the given options and parks it in
+/// the codec warm pool. Opening a hardware encoder can take hundreds of
+/// milliseconds and dominates the time from creating a sender to the first
+/// frame; calling this at application start for the usual configuration makes
+/// later `create_sender` calls reuse the already-open context.
+pub fn prewarm_video_encoder(options: &VideoOptions) -> Result<(), HylaranaSenderError> {
+    Ok(codec::prewarm_video_encoder(
+        sender::video_encoder_settings(options),
+    )?)
+}
+
+/// Pre-opens a video decoder context for the given codec and parks it in the
+/// codec warm pool, so later `create_receiver` calls reuse the already-open
+/// context.
+pub fn prewarm_video_decoder(decoder: VideoDecoderType) -> Result<(), HylaranaReceiverError> {
+    Ok(codec::prewarm_video_decoder(
+        receiver::video_decoder_settings(decoder),
+    )?)
+}
+
 /// Audio and video streaming events observer.
 pub trait MediaStreamObserver: Sync + Send {
     /// Callback when the sender is closed. This may be because the external
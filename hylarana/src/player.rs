@@ -1,4 +1,12 @@
-use std::{slice::from_raw_parts, sync::Arc};
+use std::{
+    cell::UnsafeCell,
+    slice::from_raw_parts,
+    sync::{
+        Arc, OnceLock,
+        atomic::{AtomicBool, AtomicUsize, Ordering},
+    },
+    thread::{self, JoinHandle},
+};
 
 use super::{
     HylaranaReceiverOptions, MediaStreamDescription, MediaStreamSink, sender::HylaranaSenderOptions,
@@ -13,26 +21,31 @@ use common::win32::d3d_texture_borrowed_raw;
 #[cfg(target_os = "macos")]
 use common::macos::{CVPixelBufferRef, PixelMomeryBuffer};
 
-#[cfg(not(target_os = "linux"))]
 use renderer::Texture2DRaw;
 
+#[cfg(target_os = "linux")]
+use common::frame::DmaBufDescriptor;
+
 use common::{
     Size,
     codec::{VideoDecoderType, VideoEncoderType},
-    frame::{AudioFrame, VideoFormat, VideoFrame, VideoSubFormat},
+    frame::{AudioFrame, OwnedVideoFrame, VideoFormat, VideoFrame, VideoSubFormat},
+    scheduler::PipelineRole,
 };
 
 use renderer::{
-    Renderer, RendererOptions, RendererSourceOptions, RendererSurfaceOptions, SurfaceTarget,
-    Texture, Texture2DBuffer, Texture2DResource,
+    Renderer, RendererOptions, RendererPresentMode, RendererSourceOptions, RendererSurfaceOptions,
+    SurfaceTarget, Texture, Texture2DBuffer, Texture2DResource,
 };
 
-use parking_lot::Mutex;
+use parking_lot::{Condvar, Mutex};
 use rodio::{OutputStream, OutputStreamHandle, Sink};
 use thiserror::Error;
 
 #[derive(Debug, Error)]
 pub enum VideoRenderError {
+    #[error(transparent)]
+    CreateThreadError(#[from] std::io::Error),
     #[error(transparent)]
     GraphicsError(#[from] renderer::GraphicsError),
     #[error("invalid d3d11texture2d texture")]
@@ -89,6 +102,7 @@ pub struct VideoRenderSourceOptions {
 pub struct VideoRenderOptions<T> {
     pub surface: VideoRenderSurfaceOptions<T>,
     pub source: VideoRenderSourceOptions,
+    pub present_mode: RendererPresentMode,
 }
 
 pub struct VideoRenderOptionsBuilder<T>(VideoRenderOptions<T>);
@@ -105,16 +119,29 @@ impl<T> VideoRenderOptionsBuilder<T> {
                     VideoFormat::NV12
                 },
             },
+            present_mode: RendererPresentMode::default(),
             surface,
         })
     }
 
+    /// Trade presentation smoothness against latency, see
+    /// [`RendererPresentMode`].
+    pub fn set_present_mode(mut self, present_mode: RendererPresentMode) -> Self {
+        self.0.present_mode = present_mode;
+        self
+    }
+
     pub fn from_sender(mut self, options: &HylaranaSenderOptions) -> Self {
-        if let Some(it) = &options.media.video {
+        if let Some(it) = options.media.videos.first() {
             self.0.source.sub_format = match it.options.codec {
                 VideoEncoderType::X265 => VideoSubFormat::SW,
                 VideoEncoderType::Qsv => VideoSubFormat::D3D11,
                 VideoEncoderType::VideoToolBox => VideoSubFormat::CvPixelBufferRef,
+                // These encode on the gpu but are fed from software capture
+                // frames, so the local preview sees software frames too.
+                VideoEncoderType::Nvenc | VideoEncoderType::Vaapi | VideoEncoderType::Amf => {
+                    VideoSubFormat::SW
+                }
             };
 
             self.0.source.size = Size {
@@ -131,7 +158,9 @@ impl<T> VideoRenderOptionsBuilder<T> {
         description: &MediaStreamDescription,
         options: &HylaranaReceiverOptions,
     ) -> Self {
-        if let Some(it) = description.video {
+        // The player renders the first video track, which is also the only
+        // one the receiver decodes.
+        if let Some(it) = description.videos.first() {
             self.0.source.format = it.format;
             self.0.source.size = it.size;
             self.0.source.sub_format = match options.codec {
@@ -150,6 +179,13 @@ impl<T> VideoRenderOptionsBuilder<T> {
                         VideoSubFormat::SW
                     }
                 }
+                VideoDecoderType::Vaapi => {
+                    if it.format == VideoFormat::I420 {
+                        VideoSubFormat::SW
+                    } else {
+                        VideoSubFormat::DmaBuf
+                    }
+                }
             };
         }
 
@@ -166,17 +202,17 @@ impl<T> VideoRenderOptionsBuilder<T> {
 /// This player is used to quickly and easily create a player that implements
 /// AVFrameStream, you only need to focus on the stream observer, the rest of
 /// the player will be automatically hosted.
-pub struct AVFrameStreamPlayer<'a> {
-    video: Option<Mutex<VideoRender<'a>>>,
+pub struct AVFrameStreamPlayer {
+    video: Option<Mutex<VideoRender>>,
     audio: Option<AudioRender>,
 }
 
-impl<'a> AVFrameStreamPlayer<'a> {
+impl AVFrameStreamPlayer {
     pub fn new<T>(
         options: AVFrameStreamPlayerOptions<T>,
     ) -> Result<Arc<Self>, AVFrameStreamPlayerError>
     where
-        T: Into<SurfaceTarget<'a>>,
+        T: Into<SurfaceTarget<'static>>,
     {
         Ok(Arc::new(Self {
             audio: match options {
@@ -202,7 +238,7 @@ impl<'a> AVFrameStreamPlayer<'a> {
     }
 }
 
-impl<'a> MediaStreamSink for Arc<AVFrameStreamPlayer<'a>> {
+impl MediaStreamSink for Arc<AVFrameStreamPlayer> {
     fn audio(&self, frame: &AudioFrame) -> bool {
         if let Some(player) = &self.audio {
             if let Err(e) = player.send(frame) {
@@ -230,16 +266,81 @@ impl<'a> MediaStreamSink for Arc<AVFrameStreamPlayer<'a>> {
     }
 }
 
-struct AudioSamples {
+// Preallocated lock-free single producer single consumer sample ring between
+// the decoder thread and the audio device callback. The indices only ever
+// grow and are masked into the power of two buffer, the writer publishes with
+// a release store on the write index and the reader with a release store on
+// the read index, so neither side ever blocks or allocates.
+struct AudioRing {
+    samples: UnsafeCell<Box<[i16]>>,
+    write: AtomicUsize,
+    read: AtomicUsize,
     sample_rate: u32,
-    buffer: Vec<i16>,
-    index: usize,
-    frames: usize,
 }
 
-impl rodio::Source for AudioSamples {
+// The two sides only touch the disjoint region between the indices they own.
+unsafe impl Send for AudioRing {}
+unsafe impl Sync for AudioRing {}
+
+impl AudioRing {
+    // Backlog above which incoming frames are dropped. This bounds the audio
+    // latency added by the output path and keeps it in a range where a/v
+    // sync is maintainable.
+    const MAX_BACKLOG_MS: u32 = 100;
+
+    // The ring holds twice the backlog bound, so the writer trims well
+    // before the ring itself can overflow.
+    fn new(sample_rate: u32) -> Self {
+        let capacity = (sample_rate as usize * 2 * Self::MAX_BACKLOG_MS as usize * 2 / 1000)
+            .next_power_of_two();
+
+        Self {
+            samples: UnsafeCell::new(vec![0; capacity].into_boxed_slice()),
+            write: AtomicUsize::new(0),
+            read: AtomicUsize::new(0),
+            sample_rate,
+        }
+    }
+
+    // Samples currently buffered but not yet played, expressed as latency.
+    fn backlog_ms(&self) -> u32 {
+        let backlog = self.write.load(Ordering::Relaxed) - self.read.load(Ordering::Relaxed);
+        (backlog as u64 / 2 * 1000 / self.sample_rate as u64) as u32
+    }
+
+    fn push(&self, data: &[i16]) -> bool {
+        let samples = unsafe { &mut **self.samples.get() };
+        let capacity = samples.len();
+
+        let read = self.read.load(Ordering::Acquire);
+        let write = self.write.load(Ordering::Relaxed);
+        if write - read + data.len() > capacity {
+            return false;
+        }
+
+        for (i, sample) in data.iter().enumerate() {
+            samples[(write + i) & (capacity - 1)] = *sample;
+        }
+
+        self.write.store(write + data.len(), Ordering::Release);
+        true
+    }
+}
+
+// The device callback side of the ring, it lives inside the rodio sink for
+// the whole session instead of one source per frame. On underrun it feeds
+// the device silence, ending the source would tear the stream down.
+struct AudioRingSource {
+    ring: Arc<AudioRing>,
+    // Local mirror of the write index, refreshed only when caught up so the
+    // per sample cost is a plain comparison.
+    cached_write: usize,
+    read: usize,
+}
+
+impl rodio::Source for AudioRingSource {
     fn current_frame_len(&self) -> Option<usize> {
-        Some(self.frames)
+        None
     }
 
     fn channels(&self) -> u16 {
@@ -247,7 +348,7 @@ impl rodio::Source for AudioSamples {
     }
 
     fn sample_rate(&self) -> u32 {
-        self.sample_rate
+        self.ring.sample_rate
     }
 
     fn total_duration(&self) -> Option<std::time::Duration> {
@@ -255,25 +356,25 @@ impl rodio::Source for AudioSamples {
     }
 }
 
-impl Iterator for AudioSamples {
+impl Iterator for AudioRingSource {
     type Item = i16;
 
     fn next(&mut self) -> Option<Self::Item> {
-        let item = self.buffer.get(self.index).map(|it| *it);
-        self.index += 1;
-        item
-    }
-}
-
-impl From<&AudioFrame> for AudioSamples {
-    fn from(frame: &AudioFrame) -> Self {
-        Self {
-            index: 0,
-            frames: frame.frames as usize,
-            sample_rate: frame.sample_rate,
-            buffer: unsafe { from_raw_parts(frame.data as *const i16, frame.frames as usize * 2) }
-                .to_vec(),
+        if self.read == self.cached_write {
+            self.cached_write = self.ring.write.load(Ordering::Acquire);
         }
+
+        Some(if self.read == self.cached_write {
+            0
+        } else {
+            let samples = unsafe { &**self.ring.samples.get() };
+            let sample = samples[self.read & (samples.len() - 1)];
+
+            self.read += 1;
+            self.ring.read.store(self.read, Ordering::Release);
+
+            sample
+        })
     }
 }
 
@@ -284,6 +385,8 @@ pub struct AudioRender {
     #[allow(dead_code)]
     stream_handle: OutputStreamHandle,
     sink: Sink,
+    // Created on the first frame, that is when the sample rate is known.
+    ring: OnceLock<Arc<AudioRing>>,
 }
 
 unsafe impl Send for AudioRender {}
@@ -300,14 +403,49 @@ impl AudioRender {
             stream_handle,
             stream,
             sink,
+            ring: OnceLock::new(),
         })
     }
 
-    /// Push an audio clip to the queue.
+    /// Push an audio clip to the ring. The samples are copied into the
+    /// preallocated ring and the device callback drains it directly, no
+    /// allocation or queueing happens per frame.
     pub fn send(&self, frame: &AudioFrame) -> Result<(), AudioRenderError> {
-        self.sink.append(AudioSamples::from(frame));
+        let ring = self.ring.get_or_init(|| {
+            let ring = Arc::new(AudioRing::new(frame.sample_rate));
+            self.sink.append(AudioRingSource {
+                ring: ring.clone(),
+                cached_write: 0,
+                read: 0,
+            });
+
+            ring
+        });
+
+        // Trim the backlog by dropping the frame instead of queueing it,
+        // otherwise scheduling jitter lets the latency creep up without
+        // bound. The device callback keeps playing what is already buffered.
+        if ring.backlog_ms() > AudioRing::MAX_BACKLOG_MS {
+            log::warn!(
+                "audio backlog over bound, dropping a frame, backlog={}ms",
+                ring.backlog_ms()
+            );
+
+            return Ok(());
+        }
+
+        if !ring.push(unsafe { from_raw_parts(frame.data, frame.frames as usize * 2) }) {
+            return Err(AudioRenderError::SendQueueError);
+        }
+
         Ok(())
     }
+
+    /// How far the audio output currently runs behind the decoder, useful
+    /// for a/v sync decisions.
+    pub fn backlog_ms(&self) -> u32 {
+        self.ring.get().map(|it| it.backlog_ms()).unwrap_or(0)
+    }
 }
 
 impl Drop for AudioRender {
@@ -316,22 +454,126 @@ impl Drop for AudioRender {
     }
 }
 
+// Lock-free triple buffer between the decoder thread and the render thread.
+// The writer copies into its privately owned back slot and publishes it by
+// atomically swapping it with the middle slot, the reader flips the middle
+// slot into its front slot when the fresh bit is set. Neither side ever waits
+// for the other: when the renderer lags behind the decoder, frames in the
+// middle slot are simply overwritten and the newest complete frame wins.
+struct TripleBuffer {
+    slots: [UnsafeCell<Option<OwnedVideoFrame>>; 3],
+    // Index of the middle slot in the low bits plus the fresh bit.
+    middle: AtomicUsize,
+    // Used only to park the render thread while nothing is fresh, never held
+    // around any frame data or renderer work.
+    signal: Mutex<bool>,
+    notify: Condvar,
+    closed: AtomicBool,
+}
+
+// The slots are only ever touched by the side that currently owns the index,
+// ownership is handed over through the atomic swaps on the middle slot.
+unsafe impl Send for TripleBuffer {}
+unsafe impl Sync for TripleBuffer {}
+
+impl TripleBuffer {
+    const FRESH: usize = 0b100;
+
+    fn new() -> Self {
+        Self {
+            slots: [
+                UnsafeCell::new(None),
+                UnsafeCell::new(None),
+                UnsafeCell::new(None),
+            ],
+            middle: AtomicUsize::new(1),
+            signal: Mutex::new(false),
+            notify: Condvar::new(),
+            closed: AtomicBool::new(false),
+        }
+    }
+
+    // Called by the decoder with the slot index it owns, copies the frame in
+    // and publishes it, returning the slot the decoder owns afterwards. The
+    // copy itself happens in the privately owned slot, outside any lock.
+    fn publish(&self, back: usize, frame: &VideoFrame) -> usize {
+        let buffer = unsafe { &mut *self.slots[back].get() }
+            .take()
+            .map(|it| it.buffer)
+            .unwrap_or_default();
+
+        unsafe {
+            *self.slots[back].get() = Some(OwnedVideoFrame::copy(frame, buffer));
+        }
+
+        let middle = self.middle.swap(back | Self::FRESH, Ordering::AcqRel);
+
+        *self.signal.lock() = true;
+        self.notify.notify_one();
+
+        middle & !Self::FRESH
+    }
+
+    // Called by the render thread with the slot index it owns, returns the
+    // new front slot when a frame was published since the last flip.
+    fn flip(&self, front: usize) -> Option<usize> {
+        if self.middle.load(Ordering::Acquire) & Self::FRESH == 0 {
+            return None;
+        }
+
+        Some(self.middle.swap(front, Ordering::AcqRel) & !Self::FRESH)
+    }
+
+    fn close(&self) {
+        self.closed.store(true, Ordering::Relaxed);
+
+        *self.signal.lock() = true;
+        self.notify.notify_one();
+    }
+}
+
+// The decoder facing side of the triple buffer plus the render thread that
+// drains it.
+struct VideoExchange {
+    buffer: Arc<TripleBuffer>,
+    back: usize,
+    thread: Option<JoinHandle<()>>,
+}
+
+impl Drop for VideoExchange {
+    fn drop(&mut self) {
+        self.buffer.close();
+
+        if let Some(thread) = self.thread.take() {
+            let _ = thread.join();
+        }
+    }
+}
+
 /// Video player that can render video frames to window.
-pub struct VideoRender<'a>(Renderer<'a>);
+pub struct VideoRender {
+    renderer: Arc<Mutex<Renderer<'static>>>,
+    exchange: Option<VideoExchange>,
+}
 
-impl<'a> VideoRender<'a> {
+impl VideoRender {
     /// Create a video player.
     pub fn new<T>(
-        VideoRenderOptions { surface, source }: VideoRenderOptions<T>,
+        VideoRenderOptions {
+            surface,
+            source,
+            present_mode,
+        }: VideoRenderOptions<T>,
     ) -> Result<Self, VideoRenderError>
     where
-        T: Into<SurfaceTarget<'a>>,
+        T: Into<SurfaceTarget<'static>>,
     {
         log::info!("create video render, size={:?}", surface.size);
 
         #[cfg(target_os = "windows")]
         let direct3d = get_direct3d();
 
+        let sub_format = source.sub_format;
         let options = RendererOptions {
             #[cfg(target_os = "windows")]
             direct3d,
@@ -344,171 +586,276 @@ impl<'a> VideoRender<'a> {
                 format: source.format,
                 sub_format: source.sub_format,
             },
+            present_mode,
+        };
+
+        let renderer = Arc::new(Mutex::new(Renderer::new(options)?));
+
+        // Software frames are deep copied anyway, routing them through the
+        // triple buffer to a dedicated render thread means a vsync bound
+        // present never blocks the decoder. Gpu frames are temporary device
+        // handles that cannot outlive the sink callback, they stay on the
+        // inline path.
+        let exchange = if sub_format == VideoSubFormat::SW {
+            let buffer: Arc<TripleBuffer> = Arc::new(TripleBuffer::new());
+            let thread = thread::Builder::new()
+                .name("HylaranaVideoRenderThread".to_string())
+                .spawn({
+                    let renderer = renderer.clone();
+                    let buffer = buffer.clone();
+
+                    move || {
+                        PipelineRole::Render.apply();
+
+                        let mut front = 2;
+
+                        loop {
+                            {
+                                let mut fresh = buffer.signal.lock();
+                                while !*fresh {
+                                    buffer.notify.wait(&mut fresh);
+                                }
+
+                                *fresh = false;
+                            }
+
+                            if buffer.closed.load(Ordering::Relaxed) {
+                                break;
+                            }
+
+                            if let Some(next) = buffer.flip(front) {
+                                front = next;
+
+                                if let Some(frame) = unsafe { &*buffer.slots[front].get() } {
+                                    if let Err(e) = submit_frame(&renderer, &frame.as_frame()) {
+                                        log::error!("video render submit error={:?}", e);
+
+                                        break;
+                                    }
+                                }
+                            }
+                        }
+                    }
+                })?;
+
+            Some(VideoExchange {
+                buffer,
+                back: 0,
+                thread: Some(thread),
+            })
+        } else {
+            None
         };
 
-        Ok(Self(Renderer::new(options)?))
+        Ok(Self { renderer, exchange })
     }
 
     pub fn resize(&mut self, size: Size) {
-        self.0.resize(size);
+        self.renderer.lock().resize(size);
     }
 
     /// Push video frames to the queue and the player will render them as
     /// quickly as possible, basically in real time.
     pub fn send(&mut self, frame: &VideoFrame) -> Result<(), VideoRenderError> {
-        match frame.sub_format {
-            #[cfg(target_os = "windows")]
-            VideoSubFormat::D3D11 => {
-                let texture = Texture2DResource::Texture(Texture2DRaw::ID3D11Texture2D(
-                    d3d_texture_borrowed_raw(&(frame.data[0] as *mut _))
-                        .ok_or_else(|| VideoRenderError::InvalidD3D11Texture)?
-                        .clone(),
-                    frame.data[1] as u32,
-                ));
+        // Software frames only pass through the triple buffer, the decoder
+        // returns immediately no matter what the present path is doing.
+        if frame.sub_format == VideoSubFormat::SW {
+            if let Some(exchange) = &mut self.exchange {
+                exchange.back = exchange.buffer.publish(exchange.back, frame);
 
-                let texture = match frame.format {
-                    VideoFormat::BGRA => Texture::Bgra(texture),
-                    VideoFormat::RGBA => Texture::Rgba(texture),
-                    VideoFormat::NV12 => Texture::Nv12(texture),
-                    VideoFormat::I420 => unimplemented!("no hardware texture for I420"),
-                };
+                return Ok(());
+            }
+        }
+
+        submit_frame(&self.renderer, frame)
+    }
+}
+
+// Renders a single frame, shared between the inline path for gpu frames and
+// the render thread for software frames.
+fn submit_frame(
+    renderer: &Mutex<Renderer<'static>>,
+    frame: &VideoFrame,
+) -> Result<(), VideoRenderError> {
+    let mut renderer = renderer.lock();
+
+    // The sender can renegotiate the resolution mid-stream, in which case
+    // frames simply start arriving with new dimensions. Follow them here
+    // so the renderer's source textures are rebuilt on the fly, for an
+    // unchanged size this is free.
+    renderer.reconfigure_source(Size {
+        width: frame.width,
+        height: frame.height,
+    })?;
+
+    match frame.sub_format {
+        #[cfg(target_os = "windows")]
+        VideoSubFormat::D3D11 => {
+            let texture = Texture2DResource::Texture(Texture2DRaw::ID3D11Texture2D(
+                d3d_texture_borrowed_raw(&(frame.data[0] as *mut _))
+                    .ok_or_else(|| VideoRenderError::InvalidD3D11Texture)?
+                    .clone(),
+                frame.data[1] as u32,
+            ));
+
+            let texture = match frame.format {
+                VideoFormat::BGRA => Texture::Bgra(texture),
+                VideoFormat::RGBA => Texture::Rgba(texture),
+                VideoFormat::NV12 => Texture::Nv12(texture),
+                VideoFormat::I420 => unimplemented!("no hardware texture for I420"),
+            };
 
-                self.0.submit(texture)?;
+            renderer.submit(texture)?;
+        }
+        #[cfg(target_os = "linux")]
+        VideoSubFormat::DmaBuf => {
+            // data[0] points at the dmabuf description the decoder keeps
+            // alive until the next frame is read, the renderer imports it
+            // with its own duplicated fd.
+            let texture = Texture2DResource::Texture(Texture2DRaw::DmaBuf(unsafe {
+                *(frame.data[0] as *const DmaBufDescriptor)
+            }));
+
+            renderer.submit(match frame.format {
+                VideoFormat::NV12 => Texture::Nv12(texture),
+                VideoFormat::BGRA => Texture::Bgra(texture),
+                VideoFormat::RGBA => Texture::Rgba(texture),
+                VideoFormat::I420 => unimplemented!("no hardware texture for I420"),
+            })?;
+        }
+        #[cfg(target_os = "macos")]
+        VideoSubFormat::CvPixelBufferRef => match frame.format {
+            VideoFormat::BGRA => {
+                renderer.submit(Texture::Bgra(Texture2DResource::Texture(
+                    Texture2DRaw::CVPixelBufferRef(frame.data[0] as CVPixelBufferRef),
+                )))?;
             }
-            #[cfg(target_os = "macos")]
-            VideoSubFormat::CvPixelBufferRef => match frame.format {
-                VideoFormat::BGRA => {
-                    self.0.submit(Texture::Bgra(Texture2DResource::Texture(
-                        Texture2DRaw::CVPixelBufferRef(frame.data[0] as CVPixelBufferRef),
-                    )))?;
-                }
-                VideoFormat::RGBA => {
-                    self.0.submit(Texture::Rgba(Texture2DResource::Texture(
-                        Texture2DRaw::CVPixelBufferRef(frame.data[0] as CVPixelBufferRef),
-                    )))?;
-                }
-                _ => {
-                    let pixel_buffer = PixelMomeryBuffer::from((
-                        frame.data[0] as CVPixelBufferRef,
-                        frame.format,
-                        Size {
-                            width: frame.width,
-                            height: frame.height,
-                        },
-                    ));
-
-                    let buffer = Texture2DBuffer {
-                        buffers: &pixel_buffer.data,
-                        linesize: &frame.linesize,
-                    };
-
-                    self.0.submit(match frame.format {
-                        VideoFormat::NV12 => Texture::Nv12(Texture2DResource::Buffer(buffer)),
-                        VideoFormat::I420 => Texture::I420(buffer),
-                        _ => unreachable!(),
-                    })?;
-                }
-            },
-            VideoSubFormat::SW => {
-                let buffers = match frame.format {
-                    // RGBA stands for red green blue alpha. While it is sometimes described as a
-                    // color space, it is actually a three-channel RGB color model supplemented
-                    // with a fourth alpha channel. Alpha indicates how opaque each pixel is and
-                    // allows an image to be combined over others using alpha compositing, with
-                    // transparent areas and anti-aliasing of the edges of opaque regions. Each
-                    // pixel is a 4D vector.
-                    //
-                    // The term does not define what RGB color space is being used. It also does
-                    // not state whether or not the colors are premultiplied by the alpha value,
-                    // and if they are it does not state what color space that premultiplication
-                    // was done in. This means more information than just "RGBA" is needed to
-                    // determine how to handle an image.
-                    //
-                    // In some contexts the abbreviation "RGBA" means a specific memory layout
-                    // (called RGBA8888 below), with other terms such as "BGRA" used for
-                    // alternatives. In other contexts "RGBA" means any layout.
-                    VideoFormat::BGRA | VideoFormat::RGBA => [
-                        unsafe {
-                            from_raw_parts(
-                                frame.data[0] as *const _,
-                                frame.linesize[0] as usize * frame.height as usize,
-                            )
-                        },
-                        &[],
-                        &[],
-                    ],
-                    // YCbCr, Y′CbCr, or Y Pb/Cb Pr/Cr, also written as YCBCR or Y′CBCR, is a
-                    // family of color spaces used as a part of the color image pipeline in video
-                    // and digital photography systems. Y′ is the luma component and CB and CR are
-                    // the blue-difference and red-difference chroma components. Y′ (with prime) is
-                    // distinguished from Y, which is luminance, meaning that light intensity is
-                    // nonlinearly encoded based on gamma corrected RGB primaries.
-                    //
-                    // Y′CbCr color spaces are defined by a mathematical coordinate transformation
-                    // from an associated RGB primaries and white point. If the underlying RGB
-                    // color space is absolute, the Y′CbCr color space is an absolute color space
-                    // as well; conversely, if the RGB space is ill-defined, so is Y′CbCr. The
-                    // transformation is defined in equations 32, 33 in ITU-T H.273. Nevertheless
-                    // that rule does not apply to P3-D65 primaries used by Netflix with
-                    // BT.2020-NCL matrix, so that means matrix was not derived from primaries, but
-                    // now Netflix allows BT.2020 primaries (since 2021).[1] The same happens with
-                    // JPEG: it has BT.601 matrix derived from System M primaries, yet the
-                    // primaries of most images are BT.709.
-                    VideoFormat::NV12 => [
-                        unsafe {
-                            from_raw_parts(
-                                frame.data[0] as *const _,
-                                frame.linesize[0] as usize * frame.height as usize,
-                            )
-                        },
-                        unsafe {
-                            from_raw_parts(
-                                frame.data[1] as *const _,
-                                frame.linesize[1] as usize * frame.height as usize,
-                            )
-                        },
-                        &[],
-                    ],
-                    VideoFormat::I420 => [
-                        unsafe {
-                            from_raw_parts(
-                                frame.data[0] as *const _,
-                                frame.linesize[0] as usize * frame.height as usize,
-                            )
-                        },
-                        unsafe {
-                            from_raw_parts(
-                                frame.data[1] as *const _,
-                                frame.linesize[1] as usize * (frame.height as usize / 2),
-                            )
-                        },
-                        unsafe {
-                            from_raw_parts(
-                                frame.data[2] as *const _,
-                                frame.linesize[2] as usize * (frame.height as usize / 2),
-                            )
-                        },
-                    ],
-                };
+            VideoFormat::RGBA => {
+                renderer.submit(Texture::Rgba(Texture2DResource::Texture(
+                    Texture2DRaw::CVPixelBufferRef(frame.data[0] as CVPixelBufferRef),
+                )))?;
+            }
+            _ => {
+                let pixel_buffer = PixelMomeryBuffer::from((
+                    frame.data[0] as CVPixelBufferRef,
+                    frame.format,
+                    Size {
+                        width: frame.width,
+                        height: frame.height,
+                    },
+                ));
 
-                let texture = Texture2DBuffer {
-                    buffers: &buffers,
+                let buffer = Texture2DBuffer {
+                    buffers: &pixel_buffer.data,
                     linesize: &frame.linesize,
                 };
 
-                let texture = match frame.format {
-                    VideoFormat::BGRA => Texture::Bgra(Texture2DResource::Buffer(texture)),
-                    VideoFormat::RGBA => Texture::Rgba(Texture2DResource::Buffer(texture)),
-                    VideoFormat::NV12 => Texture::Nv12(Texture2DResource::Buffer(texture)),
-                    VideoFormat::I420 => Texture::I420(texture),
-                };
-
-                self.0.submit(texture)?;
+                renderer.submit(match frame.format {
+                    VideoFormat::NV12 => Texture::Nv12(Texture2DResource::Buffer(buffer)),
+                    VideoFormat::I420 => Texture::I420(buffer),
+                    _ => unreachable!(),
+                })?;
             }
-            #[allow(unreachable_patterns)]
-            _ => unimplemented!("not suppports the frame format = {:?}", frame.sub_format),
-        }
+        },
+        VideoSubFormat::SW => {
+            let buffers = match frame.format {
+                // RGBA stands for red green blue alpha. While it is sometimes described as a
+                // color space, it is actually a three-channel RGB color model supplemented
+                // with a fourth alpha channel. Alpha indicates how opaque each pixel is and
+                // allows an image to be combined over others using alpha compositing, with
+                // transparent areas and anti-aliasing of the edges of opaque regions. Each
+                // pixel is a 4D vector.
+                //
+                // The term does not define what RGB color space is being used. It also does
+                // not state whether or not the colors are premultiplied by the alpha value,
+                // and if they are it does not state what color space that premultiplication
+                // was done in. This means more information than just "RGBA" is needed to
+                // determine how to handle an image.
+                //
+                // In some contexts the abbreviation "RGBA" means a specific memory layout
+                // (called RGBA8888 below), with other terms such as "BGRA" used for
+                // alternatives. In other contexts "RGBA" means any layout.
+                VideoFormat::BGRA | VideoFormat::RGBA => [
+                    unsafe {
+                        from_raw_parts(
+                            frame.data[0] as *const _,
+                            frame.linesize[0] as usize * frame.height as usize,
+                        )
+                    },
+                    &[],
+                    &[],
+                ],
+                // YCbCr, Y′CbCr, or Y Pb/Cb Pr/Cr, also written as YCBCR or Y′CBCR, is a
+                // family of color spaces used as a part of the color image pipeline in video
+                // and digital photography systems. Y′ is the luma component and CB and CR are
+                // the blue-difference and red-difference chroma components. Y′ (with prime) is
+                // distinguished from Y, which is luminance, meaning that light intensity is
+                // nonlinearly encoded based on gamma corrected RGB primaries.
+                //
+                // Y′CbCr color spaces are defined by a mathematical coordinate transformation
+                // from an associated RGB primaries and white point. If the underlying RGB
+                // color space is absolute, the Y′CbCr color space is an absolute color space
+                // as well; conversely, if the RGB space is ill-defined, so is Y′CbCr. The
+                // transformation is defined in equations 32, 33 in ITU-T H.273. Nevertheless
+                // that rule does not apply to P3-D65 primaries used by Netflix with
+                // BT.2020-NCL matrix, so that means matrix was not derived from primaries, but
+                // now Netflix allows BT.2020 primaries (since 2021).[1] The same happens with
+                // JPEG: it has BT.601 matrix derived from System M primaries, yet the
+                // primaries of most images are BT.709.
+                VideoFormat::NV12 => [
+                    unsafe {
+                        from_raw_parts(
+                            frame.data[0] as *const _,
+                            frame.linesize[0] as usize * frame.height as usize,
+                        )
+                    },
+                    unsafe {
+                        from_raw_parts(
+                            frame.data[1] as *const _,
+                            frame.linesize[1] as usize * frame.height as usize,
+                        )
+                    },
+                    &[],
+                ],
+                VideoFormat::I420 => [
+                    unsafe {
+                        from_raw_parts(
+                            frame.data[0] as *const _,
+                            frame.linesize[0] as usize * frame.height as usize,
+                        )
+                    },
+                    unsafe {
+                        from_raw_parts(
+                            frame.data[1] as *const _,
+                            frame.linesize[1] as usize * (frame.height as usize / 2),
+                        )
+                    },
+                    unsafe {
+                        from_raw_parts(
+                            frame.data[2] as *const _,
+                            frame.linesize[2] as usize * (frame.height as usize / 2),
+                        )
+                    },
+                ],
+            };
 
-        Ok(())
+            let texture = Texture2DBuffer {
+                buffers: &buffers,
+                linesize: &frame.linesize,
+            };
+
+            let texture = match frame.format {
+                VideoFormat::BGRA => Texture::Bgra(Texture2DResource::Buffer(texture)),
+                VideoFormat::RGBA => Texture::Rgba(Texture2DResource::Buffer(texture)),
+                VideoFormat::NV12 => Texture::Nv12(Texture2DResource::Buffer(texture)),
+                VideoFormat::I420 => Texture::I420(texture),
+            };
+
+            renderer.submit(texture)?;
+        }
+        #[allow(unreachable_patterns)]
+        _ => unimplemented!("not suppports the frame format = {:?}", frame.sub_format),
     }
+
+    Ok(())
 }
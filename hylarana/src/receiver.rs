@@ -1,12 +1,21 @@
-use std::net::SocketAddr;
+use std::{net::SocketAddr, path::Path, sync::Arc, time::Instant};
 
-use super::{MediaStreamDescription, MediaStreamObserver, MediaStreamSink};
+use super::{MediaStreamDescription, MediaStreamObserver, MediaStreamSink, record::RecordingTee};
 
 use bytes::Bytes;
-use codec::{AudioDecoder, VideoDecoder, VideoDecoderSettings};
-use common::codec::VideoDecoderType;
+use codec::{
+    AudioDecoder, VideoDecoder, VideoDecoderSettings, acquire_video_decoder, release_video_decoder,
+};
+use common::{
+    codec::VideoDecoderType,
+    latency::{LatencyHistogram, LatencySnapshot},
+    metrics::Counter,
+};
 use thiserror::Error;
-use transport::{Buffer, StreamType, TransportOptions, TransportReceiver, TransportReceiverSink};
+use transport::{
+    Buffer, StreamType, TransportOptions, TransportReceiver, TransportReceiverSink,
+    TransportReceiverStats,
+};
 
 #[cfg(feature = "serde")]
 use serde::{Deserialize, Serialize};
@@ -32,11 +41,70 @@ pub struct HylaranaReceiverOptions {
     pub transport: TransportOptions,
 }
 
-struct ReceiverSinker<S, O> {
-    audio_decoder: AudioDecoder,
-    video_decoder: VideoDecoder,
-    observer: O,
-    sink: S,
+// Per-stage latency histograms of the receiving half of the pipeline.
+#[derive(Default)]
+pub(crate) struct ReceiverLatency {
+    decode: LatencyHistogram,
+    sink: LatencyHistogram,
+}
+
+/// Per-stage latency quantiles of the receiving pipeline, see
+/// [`HylaranaReceiver::get_latency_stats`].
+#[derive(Debug, Default, Clone, Copy)]
+pub struct HylaranaReceiverLatencyStats {
+    /// Time a video packet spends inside the decoder.
+    pub decode: LatencySnapshot,
+    /// Time a decoded video frame spends in the sink, for a player this is
+    /// the texture upload and present.
+    pub sink: LatencySnapshot,
+}
+
+// Session counters of the receiving pipeline, updated from the decode path.
+#[derive(Default)]
+pub(crate) struct ReceiverMetrics {
+    video_packets: Counter,
+    video_frames: Counter,
+    audio_frames: Counter,
+}
+
+/// Snapshot of the receiving session health, see
+/// [`HylaranaReceiver::get_stats`].
+///
+/// All counters accumulate over the whole session, a scraper diffs
+/// consecutive snapshots at its own interval.
+#[derive(Debug, Default, Clone, Copy)]
+pub struct HylaranaReceiverStats {
+    /// Receive path counters of the transport connection.
+    pub transport: TransportReceiverStats,
+    /// Encoded video packets pushed into the decoder.
+    pub video_packets: u64,
+    /// Decoded video frames delivered to the sink.
+    pub video_frames: u64,
+    /// Decoded audio frames delivered to the sink.
+    pub audio_frames: u64,
+}
+
+// Also constructed by the recording playback in `record.rs`, which feeds
+// recorded packets through the exact same decode path.
+pub(crate) struct ReceiverSinker<S, O> {
+    pub(crate) settings: VideoDecoderSettings,
+    pub(crate) audio_decoder: AudioDecoder,
+    pub(crate) video_decoder: Option<VideoDecoder>,
+    pub(crate) latency: Arc<ReceiverLatency>,
+    pub(crate) metrics: Arc<ReceiverMetrics>,
+    pub(crate) recording: RecordingTee,
+    pub(crate) observer: O,
+    pub(crate) sink: S,
+}
+
+// Builds the decoder settings for a receiver, shared between session creation
+// and the warm pool prewarming API.
+pub(crate) fn video_decoder_settings(codec: VideoDecoderType) -> VideoDecoderSettings {
+    VideoDecoderSettings {
+        codec,
+        #[cfg(target_os = "windows")]
+        direct3d: Some(get_direct3d()),
+    }
 }
 
 impl<S, O> TransportReceiverSink for ReceiverSinker<S, O>
@@ -45,19 +113,51 @@ where
     O: MediaStreamObserver + 'static,
 {
     fn sink(&mut self, buffer: Buffer<Bytes>) -> bool {
+        // The tee sees the packet before the decoder, recording costs a
+        // disk write and no codec work.
+        self.recording.write(
+            buffer.stream,
+            buffer.track,
+            buffer.ty,
+            buffer.timestamp,
+            &buffer.data,
+        );
+
         match buffer.stream {
             StreamType::Video => {
-                if let Err(e) = self.video_decoder.decode(&buffer.data, buffer.timestamp) {
+                // The sink exposes a single video lane, so only the first
+                // track is decoded for now, additional tracks are received
+                // and reordered but dropped here.
+                if buffer.track != 0 {
+                    return true;
+                }
+
+                let decoder = if let Some(decoder) = self.video_decoder.as_mut() {
+                    decoder
+                } else {
+                    return false;
+                };
+
+                self.metrics.video_packets.inc();
+
+                let decode_started = Instant::now();
+                if let Err(e) = decoder.decode(&buffer.data, buffer.timestamp) {
                     log::error!("video decode error={:?}", e);
 
                     return false;
                 } else {
-                    while let Some(frame) = self.video_decoder.read() {
+                    self.latency.decode.record(decode_started.elapsed());
+
+                    while let Some(frame) = decoder.read() {
+                        let sink_started = Instant::now();
                         if !self.sink.video(frame) {
                             log::warn!("video sink return false!");
 
                             return false;
                         }
+
+                        self.latency.sink.record(sink_started.elapsed());
+                        self.metrics.video_frames.inc();
                     }
                 }
             }
@@ -73,6 +173,8 @@ where
 
                             return false;
                         }
+
+                        self.metrics.audio_frames.inc();
                     }
                 }
             }
@@ -84,6 +186,12 @@ where
     fn close(&mut self) {
         log::info!("receiver is closed");
 
+        // Hand the still-open context back to the warm pool, the next
+        // receiver with the same codec skips the codec open entirely.
+        if let Some(decoder) = self.video_decoder.take() {
+            release_video_decoder(&self.settings, decoder);
+        }
+
         self.observer.close();
     }
 }
@@ -91,6 +199,9 @@ where
 /// Screen casting receiver.
 pub struct HylaranaReceiver {
     description: MediaStreamDescription,
+    latency: Arc<ReceiverLatency>,
+    metrics: Arc<ReceiverMetrics>,
+    recording: RecordingTee,
     #[allow(unused)]
     transport: TransportReceiver,
 }
@@ -112,27 +223,75 @@ impl HylaranaReceiver {
     {
         log::info!("create receiver");
 
+        // The warm pool hands out a recycled context when one with the same
+        // codec was prewarmed or released by an earlier session, which skips
+        // the expensive codec open.
+        let settings = video_decoder_settings(options.codec);
+        let latency: Arc<ReceiverLatency> = Default::default();
+        let metrics: Arc<ReceiverMetrics> = Default::default();
+        let recording: RecordingTee = Default::default();
+
         Ok(Self {
             description: description.clone(),
             transport: TransportReceiver::new(
                 addr,
                 options.transport.clone(),
                 ReceiverSinker {
-                    video_decoder: VideoDecoder::new(VideoDecoderSettings {
-                        codec: options.codec,
-                        #[cfg(target_os = "windows")]
-                        direct3d: Some(get_direct3d()),
-                    })?,
+                    video_decoder: Some(acquire_video_decoder(settings.clone())?),
                     audio_decoder: AudioDecoder::new()?,
+                    latency: latency.clone(),
+                    metrics: metrics.clone(),
+                    recording: recording.clone(),
+                    settings,
                     observer,
                     sink,
                 },
             )?,
+            latency,
+            metrics,
+            recording,
         })
     }
 
+    /// Starts appending every encoded packet of this session to a recording
+    /// at `dir`, replayable later with `RecordingPlayer`. The stream is
+    /// tapped before the decoder, so recording costs a disk write per
+    /// packet and no extra codec work.
+    pub fn start_recording(&self, dir: &Path) -> std::io::Result<()> {
+        self.recording.start(dir)
+    }
+
+    /// Stops a running recording and flushes its files, a no-op when none
+    /// is running.
+    pub fn stop_recording(&self) {
+        self.recording.stop();
+    }
+
+    /// Takes a snapshot of the receiving session health: the transport
+    /// receive path counters combined with the decode counters, everything
+    /// an agent needs to scrape per-session without grepping logs. Reading
+    /// never touches a lock the pipeline holds.
+    pub fn get_stats(&self) -> HylaranaReceiverStats {
+        HylaranaReceiverStats {
+            transport: self.transport.get_stats(),
+            video_packets: self.metrics.video_packets.get(),
+            video_frames: self.metrics.video_frames.get(),
+            audio_frames: self.metrics.audio_frames.get(),
+        }
+    }
+
     /// Get the media description information of the current receiver.
     pub fn get_description(&self) -> &MediaStreamDescription {
         &self.description
     }
+
+    /// Per-stage latency quantiles of the receiving pipeline, accumulated
+    /// over the whole session. The gap between the sender's local stages and
+    /// these is time on the wire plus reassembly.
+    pub fn get_latency_stats(&self) -> HylaranaReceiverLatencyStats {
+        HylaranaReceiverLatencyStats {
+            decode: self.latency.decode.snapshot(),
+            sink: self.latency.sink.snapshot(),
+        }
+    }
 }
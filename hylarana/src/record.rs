@@ -0,0 +1,638 @@
+//! Zero-transcode session recording.
+//!
+//! The transport already moves a clean sequenced representation of a
+//! session, encoded packets tagged with stream, buffer type and timestamp.
+//! Recording appends exactly those packets to disk instead of running a
+//! second decode and encode pass, so a recorded session costs a disk write
+//! per packet. A recording is a directory: fixed size segment files that
+//! each begin at a video key frame, a key frame index for seeking and
+//! sidecar files holding the codec headers that were sent once at session
+//! start. Playback maps the segments into memory and feeds the packets
+//! through the same decode path a live receiver uses, paced on the
+//! recorded wall clock.
+
+use std::{
+    fs::{self, File},
+    io::{self, BufWriter, Write},
+    path::{Path, PathBuf},
+    sync::{
+        Arc,
+        atomic::{AtomicBool, Ordering},
+    },
+    thread::{self, JoinHandle},
+    time::{Duration, Instant},
+};
+
+use bytes::Bytes;
+use codec::{AudioDecoder, acquire_video_decoder};
+use common::{codec::VideoDecoderType, scheduler::PipelineRole};
+use parking_lot::Mutex;
+use thiserror::Error;
+use transport::{Buffer, BufferType, StreamType, TransportReceiverSink};
+
+use super::{
+    MediaStreamObserver, MediaStreamSink,
+    receiver::{ReceiverSinker, video_decoder_settings},
+};
+
+const MAGIC: [u8; 4] = *b"HREC";
+const VERSION: u8 = 1;
+
+// Magic plus version at the start of every segment and index file.
+const FILE_HEADER_SIZE: usize = 5;
+
+// stream u8, track u8, type u8, position u32, timestamp u64, length u32.
+const RECORD_HEAD_SIZE: usize = 19;
+
+// segment u32, offset u64, position u32, timestamp u64.
+const INDEX_ENTRY_SIZE: usize = 24;
+
+// Segments rotate at the first key frame past this size, large enough that
+// rotation is rare, small enough that the non-mmap fallback can afford to
+// read a whole segment.
+const MAX_SEGMENT_SIZE: u64 = 64 * 1024 * 1024;
+
+#[derive(Debug, Error)]
+pub enum RecordingError {
+    #[error(transparent)]
+    IoError(#[from] io::Error),
+    #[error(transparent)]
+    VideoDecoderError(#[from] codec::VideoDecoderError),
+    #[error(transparent)]
+    AudioDecoderError(#[from] codec::AudioDecoderError),
+    #[error("not a recording or unsupported version")]
+    InvalidFormat,
+}
+
+fn segment_path(dir: &Path, index: u32) -> PathBuf {
+    dir.join(format!("{:06}.seg", index))
+}
+
+/// Appends encoded packets to a recording directory.
+///
+/// Segments start at video key frames of the first track, so every index
+/// entry points at a position playback can decode from without history.
+/// Video packets before the first key frame cannot be decoded by anyone
+/// and are dropped. Codec config buffers go to sidecar files instead of
+/// the segments, the reader replays them ahead of any start position.
+pub struct RecordingWriter {
+    dir: PathBuf,
+    started: Instant,
+    index: File,
+    segment: BufWriter<File>,
+    segment_index: u32,
+    segment_size: u64,
+    video_config_saved: bool,
+    audio_config_saved: bool,
+    saw_key_frame: bool,
+}
+
+impl RecordingWriter {
+    pub fn create(dir: &Path) -> Result<Self, io::Error> {
+        fs::create_dir_all(dir)?;
+
+        let mut index = File::create(dir.join("keyframes.idx"))?;
+        index.write_all(&MAGIC)?;
+        index.write_all(&[VERSION])?;
+
+        Ok(Self {
+            segment: Self::create_segment(dir, 0)?,
+            dir: dir.to_path_buf(),
+            started: Instant::now(),
+            index,
+            segment_index: 0,
+            segment_size: FILE_HEADER_SIZE as u64,
+            video_config_saved: false,
+            audio_config_saved: false,
+            saw_key_frame: false,
+        })
+    }
+
+    fn create_segment(dir: &Path, index: u32) -> Result<BufWriter<File>, io::Error> {
+        let mut segment = BufWriter::new(File::create(segment_path(dir, index))?);
+        segment.write_all(&MAGIC)?;
+        segment.write_all(&[VERSION])?;
+
+        Ok(segment)
+    }
+
+    pub fn write(
+        &mut self,
+        stream: StreamType,
+        track: u8,
+        ty: BufferType,
+        timestamp: u64,
+        data: &[u8],
+    ) -> Result<(), io::Error> {
+        // Codec headers are needed at every start position, not just the
+        // point in the stream where they happened to be sent, so they live
+        // next to the segments instead of inside them.
+        if ty == BufferType::Config {
+            if track == 0 {
+                match stream {
+                    StreamType::Video if !self.video_config_saved => {
+                        fs::write(self.dir.join("video.cfg"), data)?;
+                        self.video_config_saved = true;
+                    }
+                    StreamType::Audio if !self.audio_config_saved => {
+                        fs::write(self.dir.join("audio.cfg"), data)?;
+                        self.audio_config_saved = true;
+                    }
+                    _ => (),
+                }
+            }
+
+            return Ok(());
+        }
+
+        let key_frame = stream == StreamType::Video && track == 0 && ty == BufferType::KeyFrame;
+
+        // Video before the first key frame cannot be decoded from this
+        // recording, audio packets are independent and kept.
+        if stream == StreamType::Video {
+            if key_frame {
+                self.saw_key_frame = true;
+            } else if !self.saw_key_frame {
+                return Ok(());
+            }
+        }
+
+        if key_frame && self.segment_size >= MAX_SEGMENT_SIZE {
+            self.segment.flush()?;
+
+            self.segment_index += 1;
+            self.segment = Self::create_segment(&self.dir, self.segment_index)?;
+            self.segment_size = FILE_HEADER_SIZE as u64;
+        }
+
+        let position = self.started.elapsed().as_millis() as u32;
+
+        if key_frame {
+            let mut entry = [0u8; INDEX_ENTRY_SIZE];
+            entry[..4].copy_from_slice(&self.segment_index.to_le_bytes());
+            entry[4..12].copy_from_slice(&self.segment_size.to_le_bytes());
+            entry[12..16].copy_from_slice(&position.to_le_bytes());
+            entry[16..24].copy_from_slice(&timestamp.to_le_bytes());
+
+            // The segment is flushed up to the entry's offset first, a
+            // reader that opens the recording while it is still being
+            // written only ever follows an index entry into complete data.
+            self.segment.flush()?;
+            self.index.write_all(&entry)?;
+        }
+
+        let mut head = [0u8; RECORD_HEAD_SIZE];
+        head[0] = stream as u8;
+        head[1] = track;
+        head[2] = ty as u8;
+        head[3..7].copy_from_slice(&position.to_le_bytes());
+        head[7..15].copy_from_slice(&timestamp.to_le_bytes());
+        head[15..19].copy_from_slice(&(data.len() as u32).to_le_bytes());
+
+        self.segment.write_all(&head)?;
+        self.segment.write_all(data)?;
+        self.segment_size += (RECORD_HEAD_SIZE + data.len()) as u64;
+
+        Ok(())
+    }
+}
+
+impl Drop for RecordingWriter {
+    fn drop(&mut self) {
+        if let Err(e) = self.segment.flush() {
+            log::error!("recording segment flush failed, err={:?}", e);
+        }
+    }
+}
+
+// The shared slot through which the pipeline tees packets into an optional
+// recording. Inactive it costs one uncontended lock per packet. It also
+// remembers the codec headers that passed through, so a recording started
+// mid session still gets them.
+#[derive(Default, Clone)]
+pub(crate) struct RecordingTee(Arc<Mutex<TeeState>>);
+
+#[derive(Default)]
+struct TeeState {
+    writer: Option<RecordingWriter>,
+    video_config: Option<Bytes>,
+    audio_config: Option<Bytes>,
+}
+
+impl RecordingTee {
+    pub(crate) fn start(&self, dir: &Path) -> Result<(), io::Error> {
+        let mut state = self.0.lock();
+        let mut writer = RecordingWriter::create(dir)?;
+
+        // The codec headers were sent once at session start, replay them
+        // from the cache into the fresh recording.
+        if let Some(config) = &state.video_config {
+            writer.write(StreamType::Video, 0, BufferType::Config, 0, config)?;
+        }
+
+        if let Some(config) = &state.audio_config {
+            writer.write(StreamType::Audio, 0, BufferType::Config, 0, config)?;
+        }
+
+        state.writer.replace(writer);
+        Ok(())
+    }
+
+    pub(crate) fn stop(&self) {
+        drop(self.0.lock().writer.take());
+    }
+
+    pub(crate) fn write(
+        &self,
+        stream: StreamType,
+        track: u8,
+        ty: BufferType,
+        timestamp: u64,
+        data: &[u8],
+    ) {
+        let mut state = self.0.lock();
+
+        if ty == BufferType::Config && track == 0 {
+            let config = Some(Bytes::copy_from_slice(data));
+            match stream {
+                StreamType::Video => state.video_config = config,
+                StreamType::Audio => state.audio_config = config,
+            }
+        }
+
+        if let Some(writer) = state.writer.as_mut() {
+            if let Err(e) = writer.write(stream, track, ty, timestamp, data) {
+                log::error!("recording write failed, recording stops, err={:?}", e);
+
+                state.writer.take();
+            }
+        }
+    }
+}
+
+// A read only view of one segment file. On unix the file is mapped, the
+// kernel pages in only what a seek actually touches, so opening a long
+// recording is instant. Elsewhere the segment is read up front, which the
+// segment size cap keeps affordable.
+#[cfg(unix)]
+struct Segment {
+    ptr: *mut libc::c_void,
+    len: usize,
+}
+
+#[cfg(unix)]
+impl Segment {
+    fn open(path: &Path) -> Result<Self, io::Error> {
+        use std::os::fd::AsRawFd;
+
+        let file = File::open(path)?;
+        let len = file.metadata()?.len() as usize;
+        if len < FILE_HEADER_SIZE {
+            return Err(io::Error::new(
+                io::ErrorKind::UnexpectedEof,
+                "segment file too short",
+            ));
+        }
+
+        let ptr = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ,
+                libc::MAP_PRIVATE,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+
+        if ptr == libc::MAP_FAILED {
+            return Err(io::Error::last_os_error());
+        }
+
+        Ok(Self { ptr, len })
+    }
+
+    fn as_slice(&self) -> &[u8] {
+        unsafe { std::slice::from_raw_parts(self.ptr as *const u8, self.len) }
+    }
+}
+
+#[cfg(unix)]
+unsafe impl Send for Segment {}
+
+#[cfg(unix)]
+impl Drop for Segment {
+    fn drop(&mut self) {
+        unsafe {
+            libc::munmap(self.ptr, self.len);
+        }
+    }
+}
+
+#[cfg(not(unix))]
+struct Segment(Vec<u8>);
+
+#[cfg(not(unix))]
+impl Segment {
+    fn open(path: &Path) -> Result<Self, io::Error> {
+        let data = fs::read(path)?;
+        if data.len() < FILE_HEADER_SIZE {
+            return Err(io::Error::new(
+                io::ErrorKind::UnexpectedEof,
+                "segment file too short",
+            ));
+        }
+
+        Ok(Self(data))
+    }
+
+    fn as_slice(&self) -> &[u8] {
+        &self.0
+    }
+}
+
+fn open_segment(dir: &Path, index: u32) -> Result<Segment, RecordingError> {
+    let segment = Segment::open(&segment_path(dir, index))?;
+
+    let data = segment.as_slice();
+    if data[..4] != MAGIC || data[4] != VERSION {
+        return Err(RecordingError::InvalidFormat);
+    }
+
+    Ok(segment)
+}
+
+/// A video key frame inside a recording, the only points playback can
+/// start from.
+#[derive(Debug, Clone, Copy)]
+pub struct RecordingKeyframe {
+    segment: u32,
+    offset: u64,
+    /// Milliseconds from the start of the recording.
+    pub position: u32,
+    /// The capture timestamp the frame carried on the wire.
+    pub timestamp: u64,
+}
+
+/// Reads a recording back as the packet sequence that was written.
+///
+/// Every packet carries its offset in milliseconds from the start of the
+/// recording, which is what seeking and pacing work on. After opening or
+/// seeking, the cached codec headers are delivered before any packet, so a
+/// decoder can always start cold.
+pub struct RecordingReader {
+    dir: PathBuf,
+    keyframes: Vec<RecordingKeyframe>,
+    video_config: Option<Bytes>,
+    audio_config: Option<Bytes>,
+    segment: Segment,
+    segment_index: u32,
+    offset: usize,
+    pending_video_config: bool,
+    pending_audio_config: bool,
+}
+
+impl RecordingReader {
+    pub fn open(dir: &Path) -> Result<Self, RecordingError> {
+        let index = fs::read(dir.join("keyframes.idx"))?;
+        if index.len() < FILE_HEADER_SIZE || index[..4] != MAGIC || index[4] != VERSION {
+            return Err(RecordingError::InvalidFormat);
+        }
+
+        // A writer appends whole entries only, a trailing partial entry of
+        // a live recording falls off the exact chunking.
+        let mut keyframes = Vec::new();
+        for entry in index[FILE_HEADER_SIZE..].chunks_exact(INDEX_ENTRY_SIZE) {
+            keyframes.push(RecordingKeyframe {
+                segment: u32::from_le_bytes(entry[..4].try_into().unwrap()),
+                offset: u64::from_le_bytes(entry[4..12].try_into().unwrap()),
+                position: u32::from_le_bytes(entry[12..16].try_into().unwrap()),
+                timestamp: u64::from_le_bytes(entry[16..24].try_into().unwrap()),
+            });
+        }
+
+        Ok(Self {
+            segment: open_segment(dir, 0)?,
+            video_config: fs::read(dir.join("video.cfg")).ok().map(Bytes::from),
+            audio_config: fs::read(dir.join("audio.cfg")).ok().map(Bytes::from),
+            dir: dir.to_path_buf(),
+            keyframes,
+            segment_index: 0,
+            offset: FILE_HEADER_SIZE,
+            pending_video_config: true,
+            pending_audio_config: true,
+        })
+    }
+
+    /// The seekable points of this recording, in order.
+    pub fn keyframes(&self) -> &[RecordingKeyframe] {
+        &self.keyframes
+    }
+
+    /// Repositions at the last key frame at or before `position`
+    /// milliseconds, or the first key frame when the recording starts
+    /// later. Returns the position actually landed on.
+    pub fn seek(&mut self, position: u32) -> Result<u32, RecordingError> {
+        let keyframe = match self
+            .keyframes
+            .iter()
+            .rev()
+            .find(|it| it.position <= position)
+            .or(self.keyframes.first())
+        {
+            Some(it) => *it,
+            // An audio only recording has no key frames, rewind to the
+            // start instead.
+            None => {
+                self.segment = open_segment(&self.dir, 0)?;
+                self.segment_index = 0;
+                self.offset = FILE_HEADER_SIZE;
+                self.pending_video_config = true;
+                self.pending_audio_config = true;
+
+                return Ok(0);
+            }
+        };
+
+        if keyframe.segment != self.segment_index {
+            self.segment = open_segment(&self.dir, keyframe.segment)?;
+            self.segment_index = keyframe.segment;
+        }
+
+        self.offset = keyframe.offset as usize;
+        self.pending_video_config = true;
+        self.pending_audio_config = true;
+
+        Ok(keyframe.position)
+    }
+
+    /// Reads the next packet and its position in milliseconds, `None` at
+    /// the end of the recording or at a truncated tail of a recording that
+    /// is still being written.
+    pub fn read(&mut self) -> Option<(u32, Buffer<Bytes>)> {
+        if self.pending_video_config {
+            self.pending_video_config = false;
+            if let Some(data) = self.video_config.clone() {
+                return Some((
+                    0,
+                    Buffer {
+                        stream: StreamType::Video,
+                        track: 0,
+                        ty: BufferType::Config,
+                        timestamp: 0,
+                        data,
+                    },
+                ));
+            }
+        }
+
+        if self.pending_audio_config {
+            self.pending_audio_config = false;
+            if let Some(data) = self.audio_config.clone() {
+                return Some((
+                    0,
+                    Buffer {
+                        stream: StreamType::Audio,
+                        track: 0,
+                        ty: BufferType::Config,
+                        timestamp: 0,
+                        data,
+                    },
+                ));
+            }
+        }
+
+        loop {
+            let data = self.segment.as_slice();
+            if self.offset + RECORD_HEAD_SIZE <= data.len() {
+                let head = &data[self.offset..self.offset + RECORD_HEAD_SIZE];
+                let stream = StreamType::try_from(head[0]).ok()?;
+                let ty = BufferType::try_from(head[2]).ok()?;
+                let position = u32::from_le_bytes(head[3..7].try_into().unwrap());
+                let timestamp = u64::from_le_bytes(head[7..15].try_into().unwrap());
+                let len = u32::from_le_bytes(head[15..19].try_into().unwrap()) as usize;
+
+                let start = self.offset + RECORD_HEAD_SIZE;
+                if start + len > data.len() {
+                    return None;
+                }
+
+                self.offset = start + len;
+
+                return Some((
+                    position,
+                    Buffer {
+                        stream,
+                        track: head[1],
+                        ty,
+                        timestamp,
+                        data: Bytes::copy_from_slice(&data[start..start + len]),
+                    },
+                ));
+            }
+
+            // Step into the next segment, a missing file is the end of the
+            // recording.
+            match open_segment(&self.dir, self.segment_index + 1) {
+                Ok(segment) => {
+                    self.segment = segment;
+                    self.segment_index += 1;
+                    self.offset = FILE_HEADER_SIZE;
+                }
+                Err(_) => return None,
+            }
+        }
+    }
+}
+
+/// Plays a recording back into a [`MediaStreamSink`], such as an
+/// `AVFrameStreamPlayer`.
+///
+/// The packets run through the same decode path a live receiver uses and
+/// are paced on the wall clock the recording was made at. The observer's
+/// close fires when the recording ends or the player is dropped.
+pub struct RecordingPlayer {
+    closed: Arc<AtomicBool>,
+    thread: Option<JoinHandle<()>>,
+}
+
+impl RecordingPlayer {
+    /// Starts playback of the recording at `dir`, optionally seeking to
+    /// `position` milliseconds first, which snaps to the nearest earlier
+    /// key frame.
+    pub fn new<S, O>(
+        dir: &Path,
+        codec: VideoDecoderType,
+        position: Option<u32>,
+        sink: S,
+        observer: O,
+    ) -> Result<Self, RecordingError>
+    where
+        S: MediaStreamSink + 'static,
+        O: MediaStreamObserver + 'static,
+    {
+        let mut reader = RecordingReader::open(dir)?;
+        let base = if let Some(position) = position {
+            reader.seek(position)?
+        } else {
+            0
+        };
+
+        let settings = video_decoder_settings(codec);
+        let mut sinker = ReceiverSinker {
+            video_decoder: Some(acquire_video_decoder(settings.clone())?),
+            audio_decoder: AudioDecoder::new()?,
+            latency: Default::default(),
+            metrics: Default::default(),
+            recording: Default::default(),
+            settings,
+            observer,
+            sink,
+        };
+
+        let closed: Arc<AtomicBool> = Default::default();
+        let closed_ = closed.clone();
+        let thread = thread::Builder::new()
+            .name("HylaranaRecordingPlaybackThread".to_string())
+            .spawn(move || {
+                PipelineRole::Render.apply();
+
+                let started = Instant::now();
+                while !closed_.load(Ordering::Relaxed) {
+                    let Some((position, buffer)) = reader.read() else {
+                        break;
+                    };
+
+                    // Every record carries its offset from the start of the
+                    // recording, sleeping up to it replays the exact cadence
+                    // the session had.
+                    let due = Duration::from_millis(position.saturating_sub(base) as u64);
+                    let elapsed = started.elapsed();
+                    if due > elapsed {
+                        thread::sleep(due - elapsed);
+                    }
+
+                    if !sinker.sink(buffer) {
+                        break;
+                    }
+                }
+
+                sinker.close();
+            })?;
+
+        Ok(Self {
+            closed,
+            thread: Some(thread),
+        })
+    }
+}
+
+impl Drop for RecordingPlayer {
+    fn drop(&mut self) {
+        self.closed.store(true, Ordering::Relaxed);
+
+        if let Some(thread) = self.thread.take() {
+            let _ = thread.join();
+        }
+    }
+}
@@ -1,6 +1,6 @@
 use super::{
     MediaAudioStreamDescription, MediaStreamDescription, MediaStreamObserver, MediaStreamSink,
-    MediaVideoStreamDescription,
+    MediaVideoStreamDescription, record::RecordingTee,
 };
 
 #[cfg(target_os = "windows")]
@@ -8,10 +8,13 @@ use super::util::get_direct3d;
 
 use std::{
     net::SocketAddr,
+    slice::from_raw_parts,
     sync::{
         Arc, Weak,
         atomic::{AtomicBool, Ordering},
     },
+    thread::{self, JoinHandle},
+    time::{Duration, Instant},
 };
 
 use capture::{
@@ -22,16 +25,25 @@ use capture::{
 use common::{
     Size,
     codec::VideoEncoderType,
-    frame::{AudioFrame, VideoFormat, VideoFrame},
+    frame::{
+        AudioFrame, PooledVideoFrame, VideoFormat, VideoFrame, VideoFramePool, VideoSubFormat,
+    },
+    latency::{LatencyHistogram, LatencySnapshot},
+    metrics::Counter,
+    scheduler::PipelineRole,
 };
 
 use codec::{
     AudioEncoder, AudioEncoderSettings, CodecType, VideoEncoder, VideoEncoderSettings,
-    create_opus_identification_header,
+    acquire_video_encoder, create_opus_identification_header, release_video_encoder,
 };
 
+use parking_lot::{Condvar, Mutex};
 use thiserror::Error;
-use transport::{Buffer, BufferType, StreamType, TransportOptions, TransportSender};
+use transport::{
+    Buffer, BufferType, MAX_VIDEO_TRACKS, StreamType, TransportOptions, TransportSender,
+    TransportSenderStats,
+};
 
 #[cfg(feature = "serde")]
 use serde::{Deserialize, Serialize};
@@ -46,6 +58,8 @@ pub enum HylaranaSenderError {
     VideoEncoderError(#[from] codec::VideoEncoderError),
     #[error(transparent)]
     AudioEncoderError(#[from] codec::AudioEncoderError),
+    #[error("the transport supports at most {0} video tracks")]
+    TooManyVideoTracksError(usize),
 }
 
 /// Description of video coding.
@@ -80,7 +94,10 @@ pub struct HylaranaSenderTrackOptions<T> {
 #[derive(Debug, Clone)]
 #[cfg_attr(feature = "serde", derive(Deserialize, Serialize))]
 pub struct HylaranaSenderMediaOptions {
-    pub video: Option<HylaranaSenderTrackOptions<VideoOptions>>,
+    /// Every entry becomes an independently encoded video track, all of them
+    /// multiplexed over the same congestion-controlled connection in track
+    /// order. At most [`MAX_VIDEO_TRACKS`] entries are supported.
+    pub videos: Vec<HylaranaSenderTrackOptions<VideoOptions>>,
     pub audio: Option<HylaranaSenderTrackOptions<AudioOptions>>,
 }
 
@@ -92,73 +109,391 @@ pub struct HylaranaSenderOptions {
     pub transport: TransportOptions,
 }
 
-// Encoding is a relatively complex task. If you add encoding tasks to the
-// pipeline that pushes frames, it will slow down the entire pipeline.
+// Closed-loop bitrate control driven by the sender side SRT statistics.
 //
-// Here, the tasks are separated, and the encoding tasks are separated into
-// independent threads. The encoding thread is notified of task updates through
-// the optional lock.
-struct VideoSender<S> {
+// Follows the usual additive increase / multiplicative decrease scheme: when
+// the link reports loss or the send buffer starts to back up, the encoder
+// bitrate is cut sharply so the stream degrades instead of smearing into
+// multi-second recovery, and while the link stays clean the rate slowly creeps
+// back up to the configured target.
+struct RateController {
+    ceiling: u64,
+    floor: u64,
+    target: u64,
+    updated_at: Instant,
+}
+
+impl RateController {
+    // How often the SRT statistics are polled.
+    const INTERVAL: Duration = Duration::from_secs(1);
+
+    // Loss ratio above which the rate is multiplicatively decreased.
+    const LOSS_THRESHOLD: f64 = 0.02;
+
+    // Loss ratio above which the stream is considered broken enough that a
+    // key frame is needed to resynchronize the receiver.
+    const RESYNC_THRESHOLD: f64 = 0.1;
+
+    fn new(bit_rate: u64) -> Self {
+        Self {
+            ceiling: bit_rate,
+            floor: bit_rate / 8,
+            target: bit_rate,
+            updated_at: Instant::now(),
+        }
+    }
+
+    fn update(&mut self, transport: &TransportSender, encoder: &mut VideoEncoder) {
+        if self.updated_at.elapsed() < Self::INTERVAL {
+            return;
+        }
+
+        self.updated_at = Instant::now();
+
+        let stats = if let Some(stats) = transport.get_stats() {
+            stats
+        } else {
+            return;
+        };
+
+        let loss_rate = stats.loss_rate();
+        let target = if loss_rate > Self::LOSS_THRESHOLD {
+            (self.target * 3 / 4).max(self.floor)
+        } else {
+            (self.target + self.ceiling / 20).min(self.ceiling)
+        };
+
+        if target != self.target {
+            log::info!(
+                "rate controller updates bit rate, target={}, loss rate={}, rtt={}ms, send buffer={}ms",
+                target,
+                loss_rate,
+                stats.rtt_ms,
+                stats.send_buffer_ms
+            );
+
+            self.target = target;
+            encoder.set_bit_rate(target);
+        }
+
+        // With this much loss the receiver has almost certainly been stuck
+        // waiting for a key frame, emit one right away at the reduced rate
+        // instead of waiting out the gop.
+        if loss_rate > Self::RESYNC_THRESHOLD {
+            encoder.request_key_frame();
+        }
+    }
+}
+
+// Per-stage latency histograms of the sending half of the pipeline, shared
+// by all video tracks.
+#[derive(Default)]
+struct SenderLatency {
+    encode: LatencyHistogram,
+    send: LatencyHistogram,
+}
+
+/// Per-stage latency quantiles of the sending pipeline, see
+/// [`HylaranaSender::get_latency_stats`].
+#[derive(Debug, Default, Clone, Copy)]
+pub struct HylaranaSenderLatencyStats {
+    /// Time a video frame spends inside the encoder.
+    pub encode: LatencySnapshot,
+    /// Time an encoded packet spends being fragmented and handed to the
+    /// socket.
+    pub send: LatencySnapshot,
+}
+
+// Session counters of the sending pipeline, updated from the encode paths
+// and shared by all tracks.
+#[derive(Default)]
+struct SenderMetrics {
+    video_frames: Counter,
+    video_key_frames: Counter,
+    video_skipped_frames: Counter,
+    video_bytes: Counter,
+    audio_packets: Counter,
+    audio_bytes: Counter,
+}
+
+/// Snapshot of the sending session health, see [`HylaranaSender::get_stats`].
+///
+/// The codec and pipeline counters accumulate over the whole session across
+/// all tracks, a scraper diffs consecutive snapshots at its own interval.
+#[derive(Debug, Default, Clone, Copy)]
+pub struct HylaranaSenderStats {
+    /// Connection statistics, `None` while no receiver is connected. Its
+    /// interval counters reset on every read, and the rate controller reads
+    /// them about once a second, so an external scraper sees the window
+    /// since whichever read came last.
+    pub transport: Option<TransportSenderStats>,
+    /// Video frames pushed through the encoders.
+    pub video_frames: u64,
+    /// Keyframes among the encoded packets.
+    pub video_key_frames: u64,
+    /// Frames the static frame detector skipped without encoding.
+    pub video_skipped_frames: u64,
+    /// Encoded video payload bytes handed to the transport.
+    pub video_bytes: u64,
+    /// Encoded audio packets handed to the transport.
+    pub audio_packets: u64,
+    /// Encoded audio payload bytes handed to the transport.
+    pub audio_bytes: u64,
+}
+
+// Detects frames that are identical to the previous one, so encoding can be
+// skipped entirely for static content like a shared slide deck. The capture
+// backends deliver every frame without dirty region metadata, so the change
+// detection happens here instead: a sparse grid of the planes is hashed per
+// frame and compared against the previous signature. Receivers simply keep
+// presenting the last frame they got, the decoder reference on their side is
+// that very frame so the stream resumes seamlessly with a plain delta frame.
+struct StaticFrameDetector {
+    signature: u64,
+    skipped: u32,
+    refresh: u32,
+}
+
+impl StaticFrameDetector {
+    // The grid resolution, 64x64 samples per plane keep the per frame cost at
+    // a few microseconds while a single changed character on screen still
+    // crosses several sampled rows.
+    const ROWS: usize = 64;
+    const COLS: usize = 64;
+
+    fn new(frame_rate: u8) -> Self {
+        Self {
+            signature: 0,
+            skipped: 0,
+            // Even fully static content is refreshed once a second, so the
+            // gop keeps advancing and a receiver that joins mid-stream is
+            // never stuck on an empty link.
+            refresh: frame_rate.max(1) as u32,
+        }
+    }
+
+    fn is_static(&mut self, frame: &VideoFrame) -> bool {
+        // Gpu frames cannot be sampled without a readback that would cost
+        // more than the encode it saves.
+        if frame.sub_format != VideoSubFormat::SW {
+            return false;
+        }
+
+        let heights: [u32; 3] = match frame.format {
+            VideoFormat::BGRA | VideoFormat::RGBA => [frame.height, 0, 0],
+            VideoFormat::NV12 => [frame.height, frame.height / 2, 0],
+            VideoFormat::I420 => [frame.height, frame.height / 2, frame.height / 2],
+        };
+
+        // fnv-1a over the sampled bytes.
+        let mut signature: u64 = 0xcbf29ce484222325;
+        for i in 0..3 {
+            if frame.data[i].is_null() || heights[i] == 0 {
+                continue;
+            }
+
+            let rows = heights[i] as usize;
+            let cols = frame.linesize[i] as usize;
+            let plane = unsafe { from_raw_parts(frame.data[i] as *const u8, rows * cols) };
+
+            for row in (0..rows).step_by((rows / Self::ROWS).max(1)) {
+                for col in (0..cols).step_by((cols / Self::COLS).max(1)) {
+                    signature =
+                        (signature ^ plane[row * cols + col] as u64).wrapping_mul(0x100000001b3);
+                }
+            }
+        }
+
+        if signature == self.signature && self.skipped < self.refresh {
+            self.skipped += 1;
+
+            true
+        } else {
+            self.signature = signature;
+            self.skipped = 0;
+
+            false
+        }
+    }
+}
+
+// Exchange slot between the capture thread and the encode thread. The capture
+// always completes in constant time by overwriting the slot, so the encoder
+// works on the freshest frame and an encode latency spike costs one skipped
+// frame instead of stalling the capture. The frames come from a recycling
+// pool, skipped and encoded frames hand their storage back on drop, steady
+// state runs without allocation.
+#[derive(Default)]
+struct EncodeSlot {
+    state: Mutex<EncodeSlotState>,
+    notify: Condvar,
+}
+
+#[derive(Default)]
+struct EncodeSlotState {
+    frame: Option<PooledVideoFrame>,
+    closed: bool,
+}
+
+// The encoding half of the video pipeline, it owns the encoder and everything
+// that drives it. For software frames it runs on a dedicated thread behind
+// the exchange slot, for gpu frames it is driven inline from the capture.
+struct VideoEncodeWorker {
     callback: Arc<dyn Fn() + Send + Sync + 'static>,
     transport: Weak<TransportSender>,
-    encoder: VideoEncoder,
-    sink: Arc<S>,
+    rate_controller: RateController,
+    detector: StaticFrameDetector,
+    reconfigure: Arc<Mutex<Option<VideoOptions>>>,
+    settings: VideoEncoderSettings,
+    encoder: Option<VideoEncoder>,
+    latency: Arc<SenderLatency>,
+    metrics: Arc<SenderMetrics>,
+    recording: RecordingTee,
+    track: u8,
 }
 
-impl<S> VideoSender<S> {
-    fn new(
-        options: &VideoOptions,
-        transport: &Arc<TransportSender>,
-        sink: Arc<S>,
-        callback: Arc<dyn Fn() + Send + Sync + 'static>,
-    ) -> Result<Self, HylaranaSenderError> {
-        Ok(VideoSender {
-            encoder: VideoEncoder::new(VideoEncoderSettings {
-                codec: options.codec,
-                key_frame_interval: options.key_frame_interval,
-                frame_rate: options.frame_rate,
-                width: options.width,
-                height: options.height,
-                bit_rate: options.bit_rate,
-                #[cfg(target_os = "windows")]
-                direct3d: Some(get_direct3d()),
-            })?,
-            transport: Arc::downgrade(&transport),
-            callback,
-            sink,
-        })
+// Builds the encoder settings for a video track, shared between session
+// creation and the warm pool prewarming API.
+pub(crate) fn video_encoder_settings(options: &VideoOptions) -> VideoEncoderSettings {
+    VideoEncoderSettings {
+        codec: options.codec,
+        key_frame_interval: options.key_frame_interval,
+        frame_rate: options.frame_rate,
+        width: options.width,
+        height: options.height,
+        bit_rate: options.bit_rate,
+        #[cfg(target_os = "windows")]
+        direct3d: Some(get_direct3d()),
     }
 }
 
-impl<S> FrameConsumer for VideoSender<S>
-where
-    S: MediaStreamSink + 'static,
-{
-    type Frame = VideoFrame;
+impl VideoEncodeWorker {
+    // Swap the encoder for one opened with the new settings, without touching
+    // the transport or the capture. The fresh context re-emits its extradata
+    // as a config buffer on the next read, which the stream producer forwards
+    // to every receiver in-band, the decoder and renderer on the other side
+    // pick the new dimensions out of the bitstream. No part of the session is
+    // torn down.
+    fn reopen(&mut self, settings: VideoEncoderSettings) -> bool {
+        log::info!("video encoder reopen, settings={:?}", settings);
+
+        if let Some(encoder) = self.encoder.take() {
+            release_video_encoder(&self.settings, encoder);
+        }
+
+        match acquire_video_encoder(settings.clone()) {
+            Ok(encoder) => {
+                self.rate_controller = RateController::new(settings.bit_rate);
+                self.detector = StaticFrameDetector::new(settings.frame_rate);
+                self.encoder = Some(encoder);
+                self.settings = settings;
+
+                true
+            }
+            Err(e) => {
+                log::error!("video encoder reopen error={:?}", e);
+
+                false
+            }
+        }
+    }
+
+    fn encode_frame(&mut self, frame: &VideoFrame) -> bool {
+        // A pending live reconfiguration is applied here on the encoding
+        // thread, between two frames. The codec itself is negotiated at
+        // session setup and the receiver decoder cannot be swapped in-band,
+        // so it is kept from the original options.
+        if let Some(options) = self.reconfigure.lock().take() {
+            let mut settings = video_encoder_settings(&options);
+            settings.codec = self.settings.codec;
+
+            if !self.reopen(settings) {
+                return false;
+            }
+        }
+
+        // The capture size follows the shared screen, a display mode change
+        // shows up as frames arriving with different dimensions. Reopen the
+        // encoder around them instead of feeding frames that no longer match
+        // the codec context.
+        if frame.width != self.settings.width || frame.height != self.settings.height {
+            let mut settings = self.settings.clone();
+            settings.width = frame.width;
+            settings.height = frame.height;
+
+            if !self.reopen(settings) {
+                return false;
+            }
+        }
+
+        let encoder = if let Some(encoder) = self.encoder.as_mut() {
+            encoder
+        } else {
+            return false;
+        };
 
-    fn sink(&mut self, frame: &Self::Frame) -> bool {
         if let Some(transport) = self.transport.upgrade() {
+            // Let the link statistics adjust the encoder before the frame is
+            // pushed in, so rate changes take effect without extra latency.
+            self.rate_controller.update(&transport, encoder);
+
+            // A receiver that joined mid-stream or lost sync asked for an
+            // immediate keyframe over the backchannel, honor it now so the
+            // join latency is one round trip instead of a keyframe interval.
+            let key_frame_requested = transport.take_key_frame_request(self.track);
+            if key_frame_requested {
+                encoder.request_key_frame();
+            }
+
+            // An unchanged frame is not worth encoding, skip it outright
+            // unless a receiver is explicitly waiting for a key frame. For
+            // mostly static content this drops the encode cpu and the sent
+            // bitrate to the refresh cadence.
+            if !key_frame_requested && self.detector.is_static(frame) {
+                self.metrics.video_skipped_frames.inc();
+
+                return true;
+            }
+
             // Push the audio and video frames into the encoder.
-            if self.encoder.update(frame) {
+            let encode_started = Instant::now();
+            if encoder.update(frame) {
                 // Try to get the encoded data packets. The audio and video frames do not
                 // correspond to the data packets one by one, so you need to try to get
                 // multiple packets until they are empty.
-                if let Err(e) = self.encoder.encode() {
+                if let Err(e) = encoder.encode() {
                     log::error!("video encode error={:?}", e);
 
                     return false;
                 } else {
-                    while let Some((buffer, flags, timestamp)) = self.encoder.read() {
+                    self.latency.encode.record(encode_started.elapsed());
+                    self.metrics.video_frames.inc();
+
+                    while let Some((buffer, flags, timestamp)) = encoder.read() {
+                        let ty = BufferType::try_from(flags as u8).unwrap();
+
+                        self.metrics.video_bytes.add(buffer.len() as u64);
+                        if ty == BufferType::KeyFrame {
+                            self.metrics.video_key_frames.inc();
+                        }
+
+                        self.recording
+                            .write(StreamType::Video, self.track, ty, timestamp, buffer);
+
+                        let send_started = Instant::now();
                         if let Err(e) = transport.send(Buffer {
                             data: Buffer::<()>::copy_from_slice(buffer),
-                            ty: BufferType::try_from(flags as u8).unwrap(),
                             stream: StreamType::Video,
+                            track: self.track,
+                            ty,
                             timestamp,
                         }) {
                             log::warn!("video send packet to transport failed, err={:?}", e);
 
                             return false;
                         }
+
+                        self.latency.send.record(send_started.elapsed());
                     }
                 }
             } else {
@@ -167,13 +502,7 @@ where
                 return false;
             }
 
-            if self.sink.video(frame) {
-                true
-            } else {
-                log::warn!("video sink on frame return false");
-
-                false
-            }
+            true
         } else {
             log::warn!("transport weak upgrade failed, maybe is drop");
 
@@ -184,10 +513,186 @@ where
     fn close(&mut self) {
         log::info!("video sender is closed");
 
+        // Hand the still-open context back to the warm pool, the next sender
+        // with the same settings skips the codec open entirely.
+        if let Some(encoder) = self.encoder.take() {
+            release_video_encoder(&self.settings, encoder);
+        }
+
         (self.callback)();
     }
 }
 
+// The capture facing half of the video pipeline. Depending on where the
+// frames live, encoding either happens inline or on a dedicated thread fed
+// through the exchange slot.
+enum VideoEncodePath {
+    // Gpu frames carry device handles that cannot be deep copied into the
+    // slot, they keep the synchronous path.
+    Sync(VideoEncodeWorker),
+    // Software frames go through the latest-frame-wins slot to a dedicated
+    // encode thread, so an encoder hiccup never backs up into the capture.
+    Queued {
+        slot: Arc<EncodeSlot>,
+        pool: VideoFramePool,
+        thread: Option<JoinHandle<()>>,
+    },
+}
+
+struct VideoSender<S> {
+    path: VideoEncodePath,
+    sink: Arc<S>,
+}
+
+impl<S> VideoSender<S> {
+    fn new(
+        track: u8,
+        options: &VideoOptions,
+        transport: &Arc<TransportSender>,
+        reconfigure: Arc<Mutex<Option<VideoOptions>>>,
+        latency: Arc<SenderLatency>,
+        metrics: Arc<SenderMetrics>,
+        recording: RecordingTee,
+        sink: Arc<S>,
+        callback: Arc<dyn Fn() + Send + Sync + 'static>,
+    ) -> Result<Self, HylaranaSenderError> {
+        // The warm pool hands out a recycled context when one with the same
+        // settings was prewarmed or released by an earlier session, which
+        // skips the expensive codec open.
+        let settings = video_encoder_settings(options);
+        let mut worker = VideoEncodeWorker {
+            encoder: Some(acquire_video_encoder(settings.clone())?),
+            rate_controller: RateController::new(options.bit_rate),
+            detector: StaticFrameDetector::new(options.frame_rate),
+            transport: Arc::downgrade(&transport),
+            reconfigure,
+            settings,
+            callback,
+            latency,
+            metrics,
+            recording,
+            track,
+        };
+
+        // Hardware encoders are fed gpu textures straight from the capture,
+        // those cannot be copied into the exchange slot, so they keep
+        // encoding inline. The software path gets the dedicated thread.
+        let path = if CodecType::from(options.codec).is_hardware() {
+            VideoEncodePath::Sync(worker)
+        } else {
+            let slot: Arc<EncodeSlot> = Default::default();
+            let thread = thread::Builder::new()
+                .name(format!("HylaranaVideoEncodeThread-{}", track))
+                .spawn({
+                    let slot = slot.clone();
+
+                    move || {
+                        PipelineRole::Encode.apply();
+
+                        'a: loop {
+                            let frame = {
+                                let mut state = slot.state.lock();
+                                loop {
+                                    if let Some(frame) = state.frame.take() {
+                                        break frame;
+                                    }
+
+                                    if state.closed {
+                                        break 'a;
+                                    }
+
+                                    slot.notify.wait(&mut state);
+                                }
+                            };
+
+                            let ok = worker.encode_frame(&frame.as_frame());
+
+                            // Dropping the frame hands its storage back to
+                            // the pool.
+                            drop(frame);
+
+                            if !ok {
+                                slot.state.lock().closed = true;
+                                break;
+                            }
+                        }
+
+                        worker.close();
+                    }
+                })?;
+
+            VideoEncodePath::Queued {
+                slot,
+                pool: VideoFramePool::new(),
+                thread: Some(thread),
+            }
+        };
+
+        Ok(Self { path, sink })
+    }
+}
+
+impl<S> FrameConsumer for VideoSender<S>
+where
+    S: MediaStreamSink + 'static,
+{
+    type Frame = VideoFrame;
+
+    fn sink(&mut self, frame: &Self::Frame) -> bool {
+        match &mut self.path {
+            VideoEncodePath::Sync(worker) => {
+                if !worker.encode_frame(frame) {
+                    return false;
+                }
+            }
+            VideoEncodePath::Queued { slot, pool, .. } => {
+                // The pool copy happens outside the slot lock, the encode
+                // thread is never blocked behind the memcpy.
+                let frame = pool.copy(frame);
+
+                let mut state = slot.state.lock();
+                if state.closed {
+                    return false;
+                }
+
+                // Overwriting the slot is what makes this constant time: if
+                // the encoder has not picked up the previous frame yet, that
+                // frame is simply skipped and its storage goes back to the
+                // pool on drop.
+                state.frame.replace(frame);
+
+                drop(state);
+                slot.notify.notify_one();
+            }
+        }
+
+        if self.sink.video(frame) {
+            true
+        } else {
+            log::warn!("video sink on frame return false");
+
+            false
+        }
+    }
+
+    fn close(&mut self) {
+        match &mut self.path {
+            VideoEncodePath::Sync(worker) => worker.close(),
+            VideoEncodePath::Queued { slot, thread, .. } => {
+                slot.state.lock().closed = true;
+                slot.notify.notify_one();
+
+                // The encode thread releases the encoder on its way out, wait
+                // for it so the close callback has fired before the capture
+                // finishes shutting down.
+                if let Some(thread) = thread.take() {
+                    let _ = thread.join();
+                }
+            }
+        }
+    }
+}
+
 // Encoding is a relatively complex task. If you add encoding tasks to the
 // pipeline that pushes frames, it will slow down the entire pipeline.
 //
@@ -198,6 +703,8 @@ struct AudioSender<S> {
     callback: Arc<dyn Fn() + Send + Sync + 'static>,
     transport: Weak<TransportSender>,
     encoder: AudioEncoder,
+    metrics: Arc<SenderMetrics>,
+    recording: RecordingTee,
     sink: Arc<S>,
 }
 
@@ -205,20 +712,22 @@ impl<S> AudioSender<S> {
     fn new(
         options: &AudioOptions,
         transport: &Arc<TransportSender>,
+        metrics: Arc<SenderMetrics>,
+        recording: RecordingTee,
         sink: Arc<S>,
         callback: Arc<dyn Fn() + Send + Sync + 'static>,
     ) -> Result<Self, HylaranaSenderError> {
         // Create an opus header data. The opus decoder needs this data to obtain audio
         // information. Here, actively add an opus header information to the queue, and
         // the adapter layer will automatically cache it.
+        let header = create_opus_identification_header(2, options.sample_rate as u32);
+        recording.write(StreamType::Audio, 0, BufferType::Config, 0, &header);
         transport.send(Buffer {
             stream: StreamType::Audio,
+            track: 0,
             ty: BufferType::Config,
             timestamp: 0,
-            data: Buffer::<()>::copy_from_slice(&create_opus_identification_header(
-                2,
-                options.sample_rate as u32,
-            )),
+            data: Buffer::<()>::copy_from_slice(&header),
         })?;
 
         Ok(Self {
@@ -228,6 +737,8 @@ impl<S> AudioSender<S> {
             })?,
             transport: Arc::downgrade(&transport),
             callback,
+            metrics,
+            recording,
             sink,
         })
     }
@@ -252,11 +763,23 @@ where
                 // packets one by one, so you need to try to get
                 // multiple packets until they are empty.
                 while let Some((buffer, _, timestamp)) = self.encoder.read() {
+                    self.metrics.audio_packets.inc();
+                    self.metrics.audio_bytes.add(buffer.len() as u64);
+
+                    self.recording.write(
+                        StreamType::Audio,
+                        0,
+                        BufferType::Partial,
+                        timestamp,
+                        buffer,
+                    );
+
                     if let Some(transport) = self.transport.upgrade() {
                         if let Err(e) = transport.send(Buffer {
                             data: Buffer::<()>::copy_from_slice(buffer),
                             ty: BufferType::Partial,
                             stream: StreamType::Audio,
+                            track: 0,
                             timestamp,
                         }) {
                             log::warn!("audio send packet to transport failed, err={:?}", e);
@@ -297,6 +820,10 @@ pub struct HylaranaSender {
     callback: Arc<dyn Fn() + Send + Sync + 'static>,
     description: MediaStreamDescription,
     transport: Arc<TransportSender>,
+    video_reconfigure: Vec<Arc<Mutex<Option<VideoOptions>>>>,
+    latency: Arc<SenderLatency>,
+    metrics: Arc<SenderMetrics>,
+    recording: RecordingTee,
     #[allow(unused)]
     capture: Capture,
 }
@@ -317,6 +844,14 @@ impl HylaranaSender {
     {
         log::info!("create sender");
 
+        // The wire format addresses a video track with a few bits, more
+        // sources than that cannot be multiplexed over one connection.
+        if options.media.videos.len() > MAX_VIDEO_TRACKS {
+            return Err(HylaranaSenderError::TooManyVideoTracksError(
+                MAX_VIDEO_TRACKS,
+            ));
+        }
+
         let transport = Arc::new(TransportSender::new(bind, options.transport.clone())?);
 
         let callback = {
@@ -332,6 +867,16 @@ impl HylaranaSender {
             })
         };
 
+        // The slots through which a live video reconfiguration is handed to
+        // the encoding threads, one per track, each applied between two
+        // frames over there.
+        let mut video_reconfigure: Vec<Arc<Mutex<Option<VideoOptions>>>> =
+            Vec::with_capacity(options.media.videos.len());
+
+        let latency: Arc<SenderLatency> = Default::default();
+        let metrics: Arc<SenderMetrics> = Default::default();
+        let recording: RecordingTee = Default::default();
+
         let capture_options = {
             let sink = Arc::new(sink);
             let mut opt = CaptureOptions::default();
@@ -341,6 +886,8 @@ impl HylaranaSender {
                     consumer: AudioSender::new(
                         &options,
                         &transport,
+                        metrics.clone(),
+                        recording.clone(),
                         sink.clone(),
                         callback.clone(),
                     )?,
@@ -351,11 +898,20 @@ impl HylaranaSender {
                 });
             }
 
-            if let Some(HylaranaSenderTrackOptions { source, options }) = &options.media.video {
-                opt.video = Some(SourceCaptureOptions {
+            for (track, HylaranaSenderTrackOptions { source, options }) in
+                options.media.videos.iter().enumerate()
+            {
+                let reconfigure: Arc<Mutex<Option<VideoOptions>>> = Default::default();
+
+                opt.videos.push(SourceCaptureOptions {
                     consumer: VideoSender::new(
+                        track as u8,
                         options,
                         &transport,
+                        reconfigure.clone(),
+                        latency.clone(),
+                        metrics.clone(),
+                        recording.clone(),
                         sink.clone(),
                         callback.clone(),
                     )?,
@@ -371,16 +927,18 @@ impl HylaranaSender {
                         direct3d: get_direct3d(),
                     },
                 });
+
+                video_reconfigure.push(reconfigure);
             }
 
             opt
         };
 
         let description = MediaStreamDescription {
-            video: options
+            videos: options
                 .media
-                .video
-                .clone()
+                .videos
+                .iter()
                 .map(|it| MediaVideoStreamDescription {
                     format: VideoFormat::NV12,
                     fps: it.options.frame_rate,
@@ -389,7 +947,8 @@ impl HylaranaSender {
                         width: it.options.width,
                         height: it.options.height,
                     },
-                }),
+                })
+                .collect(),
             audio: options
                 .media
                 .audio
@@ -405,12 +964,80 @@ impl HylaranaSender {
 
         Ok(Self {
             capture: Capture::start(capture_options)?,
+            video_reconfigure,
             description,
             transport,
             callback,
+            latency,
+            metrics,
+            recording,
         })
     }
 
+    /// Starts appending every encoded packet of this session to a recording
+    /// at `dir`, replayable later with `RecordingPlayer`. The packets are
+    /// tapped at the encoder output, so recording costs a disk write per
+    /// packet and no extra codec work.
+    pub fn start_recording(&self, dir: &std::path::Path) -> std::io::Result<()> {
+        self.recording.start(dir)
+    }
+
+    /// Stops a running recording and flushes its files, a no-op when none
+    /// is running.
+    pub fn stop_recording(&self) {
+        self.recording.stop();
+    }
+
+    /// Takes a snapshot of the sending session health: the connection
+    /// statistics combined with the codec and pipeline counters, everything
+    /// an agent needs to scrape per-session without grepping logs. Reading
+    /// never touches a lock the pipeline holds.
+    pub fn get_stats(&self) -> HylaranaSenderStats {
+        HylaranaSenderStats {
+            transport: self.transport.get_stats(),
+            video_frames: self.metrics.video_frames.get(),
+            video_key_frames: self.metrics.video_key_frames.get(),
+            video_skipped_frames: self.metrics.video_skipped_frames.get(),
+            video_bytes: self.metrics.video_bytes.get(),
+            audio_packets: self.metrics.audio_packets.get(),
+            audio_bytes: self.metrics.audio_bytes.get(),
+        }
+    }
+
+    /// Per-stage latency quantiles of the sending pipeline, accumulated over
+    /// the whole session across all video tracks. The remainder between the
+    /// local stages here and the receiver's is time on the wire, bounded by
+    /// the round-trip time in the transport statistics.
+    pub fn get_latency_stats(&self) -> HylaranaSenderLatencyStats {
+        HylaranaSenderLatencyStats {
+            encode: self.latency.encode.snapshot(),
+            send: self.latency.send.snapshot(),
+        }
+    }
+
+    /// Reconfigure a running video track in place, e.g. to downscale under
+    /// load. The encoder is swapped behind the scenes on the encoding thread
+    /// and the new config buffer flows to all receivers in-band, so playback
+    /// continues without tearing the session down. The codec cannot be
+    /// changed this way and is kept from the original options.
+    ///
+    /// Returns `false` when the sender has no such video track.
+    pub fn reconfigure_video(&self, track: usize, options: VideoOptions) -> bool {
+        if let Some(reconfigure) = self.video_reconfigure.get(track) {
+            log::info!(
+                "sender reconfigure video, track={}, options={:?}",
+                track,
+                options
+            );
+
+            reconfigure.lock().replace(options);
+
+            true
+        } else {
+            false
+        }
+    }
+
     /// Get the media description information of the current sender. The media
     /// description is the information needed to create the receiver.
     pub fn get_description(&self) -> &MediaStreamDescription {
@@ -1,6 +1,12 @@
 mod texture;
 
-use std::{borrow::Cow, sync::Arc};
+use std::{
+    borrow::Cow,
+    sync::{
+        Arc,
+        atomic::{AtomicBool, Ordering},
+    },
+};
 
 use self::texture::{bgra::Bgra, i420::I420, nv12::Nv12, rgba::Rgba};
 use crate::{Vertex, transform::TransformError};
@@ -11,11 +17,17 @@ use crate::transform::direct3d::Transformer;
 #[cfg(target_os = "macos")]
 use crate::transform::metal::Transformer;
 
+#[cfg(target_os = "linux")]
+use crate::transform::vulkan::Transformer;
+
 use common::{
     Size,
     frame::{VideoFormat, VideoSubFormat},
 };
 
+#[cfg(target_os = "linux")]
+use common::frame::DmaBufDescriptor;
+
 use smallvec::SmallVec;
 use thiserror::Error;
 
@@ -28,13 +40,15 @@ use common::win32::{Direct3DDevice, windows::Win32::Graphics::Direct3D11::ID3D11
 use wgpu::{
     AddressMode, BindGroup, BindGroupDescriptor, BindGroupEntry, BindGroupLayout,
     BindGroupLayoutDescriptor, BindGroupLayoutEntry, BindingResource, BindingType, BlendState,
+    Buffer as WGPUBuffer, BufferDescriptor, BufferUsages, COPY_BYTES_PER_ROW_ALIGNMENT,
     ColorTargetState, ColorWrites, CommandEncoder, Device, Extent3d, FilterMode, FragmentState,
-    ImageCopyTexture, ImageDataLayout, IndexFormat, MultisampleState, Origin3d,
-    PipelineCompilationOptions, PipelineLayoutDescriptor, PrimitiveState, PrimitiveTopology, Queue,
-    RenderPipeline, RenderPipelineDescriptor, Sampler, SamplerBindingType, SamplerDescriptor,
-    ShaderModuleDescriptor, ShaderSource, ShaderStages, Texture as WGPUTexture, TextureAspect,
-    TextureDescriptor, TextureDimension, TextureFormat, TextureSampleType, TextureUsages,
-    TextureView, TextureViewDescriptor, TextureViewDimension, VertexState,
+    ImageCopyBuffer, ImageCopyTexture, ImageDataLayout, IndexFormat, Maintain, MapMode,
+    MultisampleState, Origin3d, PipelineCompilationOptions, PipelineLayoutDescriptor,
+    PrimitiveState, PrimitiveTopology, RenderPipeline, RenderPipelineDescriptor, Sampler,
+    SamplerBindingType, SamplerDescriptor, ShaderModuleDescriptor, ShaderSource, ShaderStages,
+    Texture as WGPUTexture, TextureAspect, TextureDescriptor, TextureDimension, TextureFormat,
+    TextureSampleType, TextureUsages, TextureView, TextureViewDescriptor, TextureViewDimension,
+    VertexState,
 };
 
 #[derive(Debug, Error)]
@@ -49,6 +63,8 @@ pub enum Texture2DRaw {
     ID3D11Texture2D(ID3D11Texture2D, u32),
     #[cfg(target_os = "macos")]
     CVPixelBufferRef(CVPixelBufferRef),
+    #[cfg(target_os = "linux")]
+    DmaBuf(DmaBufDescriptor),
 }
 
 #[derive(Debug)]
@@ -196,28 +212,174 @@ trait Texture2DSample {
         })
     }
 
-    /// Schedule a write of some data into a texture.
-    fn update(&self, queue: &Queue, resource: &Texture2DBuffer) {
-        for (buffer, texture, aspect, size) in self.copy_buffer_descriptors(resource.buffers) {
-            queue.write_texture(
+    /// Schedule a write of some data into a texture. The planes go through
+    /// the persistent staging memory and the copies are recorded into the
+    /// frame's command encoder, so they reach the gpu in the same submission
+    /// as the render pass.
+    fn update(
+        &self,
+        encoder: &mut CommandEncoder,
+        staging: &mut StagingBuffers,
+        resource: &Texture2DBuffer,
+    ) {
+        staging.upload(encoder, self.copy_buffer_descriptors(resource.buffers));
+    }
+}
+
+// Rows inside a buffer to texture copy must start at a 256 byte boundary.
+fn align_bytes_per_row(bytes: u32) -> u32 {
+    bytes.div_ceil(COPY_BYTES_PER_ROW_ALIGNMENT) * COPY_BYTES_PER_ROW_ALIGNMENT
+}
+
+// One half of the staging memory. `ready` is flipped from the map callback,
+// `requested` tracks whether that callback is already on its way.
+struct StagingBuffer {
+    buffer: WGPUBuffer,
+    ready: Arc<AtomicBool>,
+    requested: bool,
+}
+
+// Persistent, double buffered staging memory for software frame uploads.
+//
+// All planes of a frame are packed into one mapped buffer and copied into
+// their textures by the frame's own command encoder, which replaces the per
+// plane `write_texture` calls and with them wgpu's internal per frame staging
+// allocation and extra copy submissions. While one half is in flight on the
+// gpu the other one is written, and each half is asynchronously remapped as
+// soon as the submission using it is out the door.
+pub(crate) struct StagingBuffers {
+    device: Arc<Device>,
+    // Allocated on the first upload, that is when the packed size of all
+    // planes is known.
+    buffers: Option<[StagingBuffer; 2]>,
+    index: usize,
+}
+
+impl StagingBuffers {
+    fn new(device: Arc<Device>) -> Self {
+        Self {
+            device,
+            buffers: None,
+            index: 0,
+        }
+    }
+
+    fn alloc(device: &Device, size: u64) -> StagingBuffer {
+        StagingBuffer {
+            buffer: device.create_buffer(&BufferDescriptor {
+                label: None,
+                size,
+                usage: BufferUsages::MAP_WRITE | BufferUsages::COPY_SRC,
+                mapped_at_creation: true,
+            }),
+            ready: Arc::new(AtomicBool::new(true)),
+            requested: false,
+        }
+    }
+
+    fn upload<'a>(
+        &mut self,
+        encoder: &mut CommandEncoder,
+        planes: impl IntoIterator<Item = (&'a [u8], &'a WGPUTexture, TextureAspect, Size)>,
+    ) {
+        let planes: SmallVec<[(&[u8], &WGPUTexture, TextureAspect, Size); 3]> =
+            planes.into_iter().collect();
+
+        let size: u64 = planes
+            .iter()
+            .map(|(_, _, _, size)| align_bytes_per_row(size.width) as u64 * size.height as u64)
+            .sum();
+
+        let buffers = self.buffers.get_or_insert_with(|| {
+            [
+                Self::alloc(&self.device, size),
+                Self::alloc(&self.device, size),
+            ]
+        });
+
+        // The other half was submitted with the previous frame, request its
+        // remap now so it resolves on the device timeline while this frame
+        // is being written and rendered.
+        {
+            let previous = &mut buffers[self.index ^ 1];
+            if !previous.requested && !previous.ready.load(Ordering::Acquire) {
+                let ready = previous.ready.clone();
+                previous
+                    .buffer
+                    .slice(..)
+                    .map_async(MapMode::Write, move |result| {
+                        if result.is_ok() {
+                            ready.store(true, Ordering::Release);
+                        }
+                    });
+
+                previous.requested = true;
+            }
+        }
+
+        let current = &mut buffers[self.index];
+
+        // With double buffering the remap normally resolved a frame ago,
+        // block on the device only when the gpu is running that far behind.
+        if !current.ready.load(Ordering::Acquire) {
+            let _ = self.device.poll(Maintain::Wait);
+        }
+
+        current.requested = false;
+
+        {
+            let mut view = current.buffer.slice(..).get_mapped_range_mut();
+
+            let mut offset = 0;
+            for (data, _, _, size) in &planes {
+                let bytes_per_row = size.width as usize;
+                let padded = align_bytes_per_row(size.width) as usize;
+
+                if bytes_per_row == padded {
+                    let length = bytes_per_row * size.height as usize;
+                    view[offset..offset + length].copy_from_slice(&data[..length]);
+                } else {
+                    for row in 0..size.height as usize {
+                        view[offset + row * padded..offset + row * padded + bytes_per_row]
+                            .copy_from_slice(&data[row * bytes_per_row..][..bytes_per_row]);
+                    }
+                }
+
+                offset += padded * size.height as usize;
+            }
+        }
+
+        current.buffer.unmap();
+        current.ready.store(false, Ordering::Relaxed);
+
+        let mut offset = 0;
+        for (_, texture, aspect, size) in &planes {
+            encoder.copy_buffer_to_texture(
+                ImageCopyBuffer {
+                    buffer: &current.buffer,
+                    layout: ImageDataLayout {
+                        offset,
+                        // Bytes per "row" in an image.
+                        //
+                        // A row is one row of pixels or of compressed blocks
+                        // in the x direction.
+                        bytes_per_row: Some(align_bytes_per_row(size.width)),
+                        rows_per_image: Some(size.height),
+                    },
+                },
                 ImageCopyTexture {
-                    aspect,
+                    aspect: *aspect,
                     texture,
                     mip_level: 0,
                     origin: Origin3d::ZERO,
                 },
-                buffer,
-                ImageDataLayout {
-                    offset: 0,
-                    // Bytes per "row" in an image.
-                    //
-                    // A row is one row of pixels or of compressed blocks in the x direction.
-                    bytes_per_row: Some(size.width),
-                    rows_per_image: Some(size.height),
-                },
                 texture.size(),
             );
+
+            offset += align_bytes_per_row(size.width) as u64 * size.height as u64;
         }
+
+        self.index ^= 1;
     }
 }
 
@@ -232,7 +394,6 @@ pub struct BackBufferOptions {
     #[cfg(target_os = "windows")]
     pub direct3d: Direct3DDevice,
     pub device: Arc<Device>,
-    pub queue: Arc<Queue>,
     pub format: VideoFormat,
     pub sub_format: VideoSubFormat,
     pub size: Size,
@@ -240,12 +401,11 @@ pub struct BackBufferOptions {
 
 pub struct BackBuffer {
     device: Arc<Device>,
-    queue: Arc<Queue>,
+    staging: StagingBuffers,
     sampler: Sampler,
     layout: BindGroupLayout,
     pipeline: RenderPipeline,
     sample: Texture2DSourceSample,
-    #[cfg(not(target_os = "linux"))]
     transformer: Option<Transformer>,
 }
 
@@ -253,7 +413,6 @@ impl BackBuffer {
     pub fn new(
         BackBufferOptions {
             device,
-            queue,
             format,
             sub_format,
             size,
@@ -261,7 +420,6 @@ impl BackBuffer {
             direct3d,
         }: BackBufferOptions,
     ) -> Result<Self, BackBufferError> {
-        #[cfg(not(target_os = "linux"))]
         let transformer = {
             if sub_format != VideoSubFormat::SW {
                 #[cfg(target_os = "windows")]
@@ -273,6 +431,11 @@ impl BackBuffer {
                 {
                     Some(Transformer::new(device.clone(), size, format)?)
                 }
+
+                #[cfg(target_os = "linux")]
+                {
+                    Some(Transformer::new(device.clone(), size, format)?)
+                }
             } else {
                 None
             }
@@ -345,10 +508,9 @@ impl BackBuffer {
         });
 
         Ok(Self {
-            #[cfg(not(target_os = "linux"))]
             transformer,
-            device: device,
-            queue: queue,
+            staging: StagingBuffers::new(device.clone()),
+            device,
             sample,
             sampler,
             layout,
@@ -372,36 +534,31 @@ impl BackBuffer {
         match &texture {
             Texture::Bgra(Texture2DResource::Buffer(buffer)) => {
                 if let Texture2DSourceSample::Bgra(it) = &self.sample {
-                    it.update(&self.queue, buffer);
+                    it.update(encoder, &mut self.staging, buffer);
                 }
             }
             Texture::Rgba(Texture2DResource::Buffer(buffer)) => {
                 if let Texture2DSourceSample::Rgba(it) = &self.sample {
-                    it.update(&self.queue, buffer);
+                    it.update(encoder, &mut self.staging, buffer);
                 }
             }
             Texture::Nv12(Texture2DResource::Buffer(buffer)) => {
                 if let Texture2DSourceSample::Nv12(it) = &self.sample {
-                    it.update(&self.queue, buffer);
+                    it.update(encoder, &mut self.staging, buffer);
                 }
             }
             Texture::I420(texture) => {
                 if let Texture2DSourceSample::I420(it) = &self.sample {
-                    it.update(&self.queue, texture);
+                    it.update(encoder, &mut self.staging, texture);
                 }
             }
             _ => (),
         }
 
-        #[cfg(target_os = "linux")]
-        let texture = None;
-
-        #[cfg(not(target_os = "linux"))]
         let texture = match &texture {
             Texture::Rgba(texture) | Texture::Bgra(texture) | Texture::Nv12(texture) => {
                 if let Some(transformer) = &mut self.transformer {
                     match texture {
-                        #[cfg(not(target_os = "linux"))]
                         Texture2DResource::Texture(texture) => match texture {
                             #[cfg(target_os = "windows")]
                             Texture2DRaw::ID3D11Texture2D(it, index) => {
@@ -411,10 +568,10 @@ impl BackBuffer {
                             Texture2DRaw::CVPixelBufferRef(it) => {
                                 Some(transformer.transform(encoder, *it)?)
                             }
+                            #[cfg(target_os = "linux")]
+                            Texture2DRaw::DmaBuf(it) => Some(transformer.transform(it)?),
                         },
                         Texture2DResource::Buffer(_) => None,
-                        #[allow(unreachable_patterns)]
-                        _ => None,
                     }
                 } else {
                     None
@@ -273,11 +273,16 @@ pub mod nv12 {
     impl Nv12 {
         pub(crate) fn new(device: &Device, size: Size, sub_format: VideoSubFormat) -> Self {
             let mut textures = Self::create(device, size, sub_format);
-            Self(if sub_format == VideoSubFormat::D3D11 {
-                None
-            } else {
-                Some((textures.next().unwrap(), textures.next().unwrap()))
-            })
+            // d3d11 and dmabuf frames are bound as plane views of the
+            // external texture, only the other sub formats need internal
+            // textures to copy into.
+            Self(
+                if matches!(sub_format, VideoSubFormat::D3D11 | VideoSubFormat::DmaBuf) {
+                    None
+                } else {
+                    Some((textures.next().unwrap(), textures.next().unwrap()))
+                },
+            )
         }
     }
 
@@ -295,7 +300,7 @@ pub mod nv12 {
             size: Size,
             sub_format: VideoSubFormat,
         ) -> impl IntoIterator<Item = (Size, TextureFormat)> {
-            if sub_format == VideoSubFormat::D3D11 {
+            if matches!(sub_format, VideoSubFormat::D3D11 | VideoSubFormat::DmaBuf) {
                 Vec::new()
             } else {
                 vec![
@@ -58,12 +58,63 @@ pub struct RendererSourceOptions {
     pub sub_format: VideoSubFormat,
 }
 
+/// Presentation policy of the renderer.
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub enum RendererPresentMode {
+    /// The platform default, a balance between latency and smoothness.
+    #[default]
+    Auto,
+    /// Prefer the lowest presentation latency the surface supports, at the
+    /// price of tearing where only immediate presentation is available. For
+    /// streaming receivers this shaves up to a refresh interval a finished
+    /// frame would otherwise spend waiting for vblank.
+    LowLatency,
+    /// Tear free vsync output, a finished frame can wait up to a full
+    /// refresh interval before it becomes visible.
+    VSync,
+}
+
+impl RendererPresentMode {
+    // Picks the first supported present mode of the policy, every surface is
+    // required to support fifo so the fallback always exists.
+    fn select(self, supported: &[PresentMode]) -> PresentMode {
+        let preference: &[PresentMode] = match self {
+            Self::Auto => {
+                if cfg!(target_os = "windows") {
+                    &[
+                        PresentMode::Mailbox,
+                        PresentMode::Immediate,
+                        PresentMode::Fifo,
+                    ]
+                } else if cfg!(target_os = "linux") {
+                    &[PresentMode::Fifo]
+                } else {
+                    &[PresentMode::Immediate, PresentMode::Fifo]
+                }
+            }
+            Self::LowLatency => &[
+                PresentMode::Mailbox,
+                PresentMode::Immediate,
+                PresentMode::Fifo,
+            ],
+            Self::VSync => &[PresentMode::Fifo],
+        };
+
+        preference
+            .iter()
+            .find(|it| supported.contains(it))
+            .copied()
+            .unwrap_or(PresentMode::Fifo)
+    }
+}
+
 #[derive(Debug)]
 pub struct RendererOptions<T> {
     #[cfg(target_os = "windows")]
     pub direct3d: common::win32::Direct3DDevice,
     pub surface: RendererSurfaceOptions<T>,
     pub source: RendererSourceOptions,
+    pub present_mode: RendererPresentMode,
 }
 
 /// Window Renderer.
@@ -75,6 +126,8 @@ pub struct RendererOptions<T> {
 /// uses the underlying GPU device, and the use of software devices is not
 /// currently supported.
 pub struct Renderer<'a> {
+    #[cfg(target_os = "windows")]
+    direct3d: common::win32::Direct3DDevice,
     config: SurfaceConfiguration,
     surface: Surface<'a>,
     device: Arc<Device>,
@@ -83,6 +136,7 @@ pub struct Renderer<'a> {
     index_buffer: Buffer,
     back_buffer: BackBuffer,
     viewport: Viewport,
+    source: RendererSourceOptions,
 }
 
 impl<'a> Renderer<'a> {
@@ -92,6 +146,7 @@ impl<'a> Renderer<'a> {
             direct3d,
             surface: RendererSurfaceOptions { window, size },
             source,
+            present_mode,
         }: RendererOptions<T>,
     ) -> Result<Self, GraphicsError> {
         let viewport = Viewport::new(source.size, size);
@@ -138,13 +193,14 @@ impl<'a> Renderer<'a> {
             .get_default_config(&adapter, size.width, size.height)
             .ok_or_else(|| GraphicsError::NotFoundSurfaceDefaultConfig)?;
 
-        config.present_mode = if cfg!(target_os = "windows") {
-            PresentMode::Mailbox
-        } else if cfg!(target_os = "linux") {
-            PresentMode::Fifo
-        } else {
-            PresentMode::Immediate
-        };
+        config.present_mode =
+            present_mode.select(&surface.get_capabilities(&adapter).present_modes);
+
+        log::info!(
+            "renderer present mode, policy={:?}, selected={:?}",
+            present_mode,
+            config.present_mode
+        );
 
         config.format = TextureFormat::Bgra8Unorm;
         config.alpha_mode = CompositeAlphaMode::Opaque;
@@ -165,15 +221,16 @@ impl<'a> Renderer<'a> {
 
         let back_buffer = BackBuffer::new(BackBufferOptions {
             device: device.clone(),
-            queue: queue.clone(),
             size: source.size,
             format: source.format,
             sub_format: source.sub_format,
             #[cfg(target_os = "windows")]
-            direct3d,
+            direct3d: direct3d.clone(),
         })?;
 
         Ok(Self {
+            #[cfg(target_os = "windows")]
+            direct3d,
             viewport,
             back_buffer,
             vertex_buffer,
@@ -182,6 +239,7 @@ impl<'a> Renderer<'a> {
             device,
             queue,
             config,
+            source,
         })
     }
 
@@ -193,6 +251,38 @@ impl<'a> Renderer<'a> {
         self.surface.configure(&self.device, &self.config);
     }
 
+    // Change the size of the source texture without recreating the renderer.
+    // The back buffer textures are tied to the source size, so they are
+    // rebuilt, while the surface, device and pipeline buffers are all kept.
+    // Calling this with an unchanged size is free.
+    pub fn reconfigure_source(&mut self, size: Size) -> Result<(), GraphicsError> {
+        if size == self.source.size {
+            return Ok(());
+        }
+
+        log::info!("renderer reconfigure source, size={:?}", size);
+
+        self.source.size = size;
+        self.viewport = Viewport::new(
+            size,
+            Size {
+                width: self.config.width,
+                height: self.config.height,
+            },
+        );
+
+        self.back_buffer = BackBuffer::new(BackBufferOptions {
+            device: self.device.clone(),
+            size,
+            format: self.source.format,
+            sub_format: self.source.sub_format,
+            #[cfg(target_os = "windows")]
+            direct3d: self.direct3d.clone(),
+        })?;
+
+        Ok(())
+    }
+
     // Submit the texture to the renderer, it should be noted that the renderer will
     // not render this texture immediately, the processing flow will enter the
     // render queue and wait for the queue to automatically schedule the rendering
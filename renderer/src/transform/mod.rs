@@ -4,6 +4,9 @@ pub mod direct3d;
 #[cfg(target_os = "macos")]
 pub mod metal;
 
+#[cfg(target_os = "linux")]
+pub mod vulkan;
+
 use thiserror::Error;
 
 #[derive(Debug, Error)]
@@ -28,4 +31,13 @@ pub enum TransformError {
     CreateCVTextureCacheError,
     #[error("failed to create cv metal texture")]
     CreateCVMetalTextureError,
+    #[cfg(target_os = "linux")]
+    #[error("vulkan error: {0}")]
+    VulkanError(#[from] ash::vk::Result),
+    #[error("not found wgpu vulkan device")]
+    NotFoundVulkanBackend,
+    #[error("failed to dup dmabuf fd")]
+    DupDmaBufFdError,
+    #[error("not found memory type for dmabuf import")]
+    NotFoundDmaBufMemoryType,
 }
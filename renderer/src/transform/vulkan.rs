@@ -0,0 +1,287 @@
+use std::{collections::VecDeque, sync::Arc};
+
+use common::{
+    Size,
+    frame::{DmaBufDescriptor, VideoFormat},
+};
+
+use ash::vk;
+use smallvec::SmallVec;
+use wgpu::{
+    Device, Extent3d, Texture, TextureDescriptor, TextureDimension, TextureFormat, TextureUsages,
+    hal::{Api, MemoryFlags, TextureUses, api::Vulkan},
+};
+
+use super::TransformError;
+
+// An imported dmabuf frame. The image does not own the pixel storage, the
+// imported memory just adds a reference to the kernel buffer behind the
+// duplicated fd, which vulkan closes when the memory is freed.
+struct Imported {
+    image: vk::Image,
+    memory: vk::DeviceMemory,
+    texture: Texture,
+}
+
+// How many imported frames stay alive behind the newest one. The submission
+// sampling an image is asynchronous, so the image cannot be destroyed the
+// moment the next frame arrives; retiring through a short FIFO ring keeps
+// each image around for a few frames past its submission, long enough for
+// the queue to have drained it.
+const IMPORTED_RING_DEPTH: usize = 3;
+
+pub struct Transformer {
+    device: Arc<Device>,
+    raw_device: ash::Device,
+    external_memory: ash::khr::external_memory_fd::Device,
+    memory_props: vk::PhysicalDeviceMemoryProperties,
+    size: Size,
+    format: TextureFormat,
+    vk_format: vk::Format,
+    // Retired in FIFO order, the oldest image goes once the ring is full.
+    imported: VecDeque<Imported>,
+}
+
+unsafe impl Send for Transformer {}
+unsafe impl Sync for Transformer {}
+
+impl Transformer {
+    pub fn new(
+        device: Arc<Device>,
+        size: Size,
+        format: VideoFormat,
+    ) -> Result<Self, TransformError> {
+        // Get the wgpu underlying vulkan device, the import needs raw device
+        // access for image creation and the external memory extension entry
+        // points.
+        let mut handles = None;
+        unsafe {
+            device.as_hal::<Vulkan, _, _>(|device| {
+                if let Some(device) = device {
+                    let instance = device.shared_instance().raw_instance();
+
+                    handles = Some((
+                        device.raw_device().clone(),
+                        ash::khr::external_memory_fd::Device::new(instance, device.raw_device()),
+                        instance
+                            .get_physical_device_memory_properties(device.raw_physical_device()),
+                    ));
+                }
+            });
+        }
+
+        let (raw_device, external_memory, memory_props) =
+            handles.ok_or_else(|| TransformError::NotFoundVulkanBackend)?;
+
+        let (format, vk_format) = match format {
+            VideoFormat::NV12 => (TextureFormat::NV12, vk::Format::G8_B8R8_2PLANE_420_UNORM),
+            VideoFormat::BGRA => (TextureFormat::Bgra8Unorm, vk::Format::B8G8R8A8_UNORM),
+            VideoFormat::RGBA => (TextureFormat::Rgba8Unorm, vk::Format::R8G8B8A8_UNORM),
+            _ => unimplemented!("unsupports format = {:?}", format),
+        };
+
+        Ok(Self {
+            device,
+            raw_device,
+            external_memory,
+            memory_props,
+            size,
+            format,
+            vk_format,
+            imported: VecDeque::with_capacity(IMPORTED_RING_DEPTH),
+        })
+    }
+
+    pub fn transform(&mut self, descriptor: &DmaBufDescriptor) -> Result<&Texture, TransformError> {
+        // Only the oldest import is old enough that every submission sampling
+        // it has finished, anything younger may still be referenced on the
+        // GPU and stays in the ring.
+        while self.imported.len() >= IMPORTED_RING_DEPTH {
+            if let Some(it) = self.imported.pop_front() {
+                self.release(it);
+            }
+        }
+
+        // Importing the fd hands its ownership to vulkan, while the fd inside
+        // the descriptor stays owned by the decoder.
+        let fd = unsafe { libc::dup(descriptor.fd) };
+        if fd < 0 {
+            return Err(TransformError::DupDmaBufFdError);
+        }
+
+        let plane_layouts: SmallVec<[vk::SubresourceLayout; 3]> = (0..descriptor.planes)
+            .map(|i| vk::SubresourceLayout {
+                offset: descriptor.offset[i],
+                row_pitch: descriptor.pitch[i],
+                size: 0,
+                array_pitch: 0,
+                depth_pitch: 0,
+            })
+            .collect();
+
+        let mut modifier_info = vk::ImageDrmFormatModifierExplicitCreateInfoEXT::default()
+            .drm_format_modifier(descriptor.modifier)
+            .plane_layouts(&plane_layouts);
+
+        let mut external_info = vk::ExternalMemoryImageCreateInfo::default()
+            .handle_types(vk::ExternalMemoryHandleTypeFlags::DMA_BUF_EXT);
+
+        let image = match unsafe {
+            self.raw_device.create_image(
+                &vk::ImageCreateInfo::default()
+                    .push_next(&mut external_info)
+                    .push_next(&mut modifier_info)
+                    .image_type(vk::ImageType::TYPE_2D)
+                    .format(self.vk_format)
+                    .extent(vk::Extent3D {
+                        width: self.size.width,
+                        height: self.size.height,
+                        depth: 1,
+                    })
+                    .mip_levels(1)
+                    .array_layers(1)
+                    .samples(vk::SampleCountFlags::TYPE_1)
+                    .tiling(vk::ImageTiling::DRM_FORMAT_MODIFIER_EXT)
+                    .usage(vk::ImageUsageFlags::SAMPLED)
+                    .sharing_mode(vk::SharingMode::EXCLUSIVE)
+                    .initial_layout(vk::ImageLayout::UNDEFINED),
+                None,
+            )
+        } {
+            Ok(image) => image,
+            Err(e) => {
+                unsafe { libc::close(fd) };
+
+                return Err(TransformError::VulkanError(e));
+            }
+        };
+
+        let memory = match self.import_memory(image, fd, descriptor.size as u64) {
+            Ok(memory) => memory,
+            Err(e) => {
+                unsafe {
+                    libc::close(fd);
+                    self.raw_device.destroy_image(image, None);
+                }
+
+                return Err(e);
+            }
+        };
+
+        if let Err(e) = unsafe { self.raw_device.bind_image_memory(image, memory, 0) } {
+            unsafe {
+                self.raw_device.destroy_image(image, None);
+                self.raw_device.free_memory(memory, None);
+            }
+
+            return Err(TransformError::VulkanError(e));
+        }
+
+        let texture = unsafe {
+            self.device.create_texture_from_hal::<Vulkan>(
+                <Vulkan as Api>::Device::texture_from_raw(
+                    image,
+                    &wgpu::hal::TextureDescriptor {
+                        label: None,
+                        size: Extent3d {
+                            width: self.size.width,
+                            height: self.size.height,
+                            depth_or_array_layers: 1,
+                        },
+                        mip_level_count: 1,
+                        sample_count: 1,
+                        dimension: TextureDimension::D2,
+                        format: self.format,
+                        usage: TextureUses::RESOURCE,
+                        memory_flags: MemoryFlags::empty(),
+                        view_formats: Vec::new(),
+                    },
+                    None,
+                ),
+                &TextureDescriptor {
+                    label: None,
+                    size: Extent3d {
+                        width: self.size.width,
+                        height: self.size.height,
+                        depth_or_array_layers: 1,
+                    },
+                    mip_level_count: 1,
+                    sample_count: 1,
+                    dimension: TextureDimension::D2,
+                    format: self.format,
+                    usage: TextureUsages::TEXTURE_BINDING,
+                    view_formats: &[],
+                },
+            )
+        };
+
+        self.imported.push_back(Imported {
+            image,
+            memory,
+            texture,
+        });
+
+        Ok(&self.imported.back().unwrap().texture)
+    }
+
+    // Destroys one retired import. The wgpu texture is dropped first, it only
+    // wraps the raw image and does not free it.
+    fn release(&self, it: Imported) {
+        drop(it.texture);
+
+        unsafe {
+            self.raw_device.destroy_image(it.image, None);
+            self.raw_device.free_memory(it.memory, None);
+        }
+    }
+
+    // Imports the dmabuf as device memory, the memory type has to satisfy
+    // both the image and whatever the kernel buffer itself requires.
+    fn import_memory(
+        &self,
+        image: vk::Image,
+        fd: i32,
+        size: u64,
+    ) -> Result<vk::DeviceMemory, TransformError> {
+        let properties = unsafe {
+            self.external_memory
+                .get_memory_fd_properties(vk::ExternalMemoryHandleTypeFlags::DMA_BUF_EXT, fd)?
+        };
+
+        let requirements = unsafe { self.raw_device.get_image_memory_requirements(image) };
+        let type_bits = requirements.memory_type_bits & properties.memory_type_bits;
+
+        let memory_type_index = (0..self.memory_props.memory_type_count)
+            .find(|it| type_bits & (1 << it) != 0)
+            .ok_or_else(|| TransformError::NotFoundDmaBufMemoryType)?;
+
+        let mut import_info = vk::ImportMemoryFdInfoKHR::default()
+            .handle_type(vk::ExternalMemoryHandleTypeFlags::DMA_BUF_EXT)
+            .fd(fd);
+
+        let mut dedicated_info = vk::MemoryDedicatedAllocateInfo::default().image(image);
+
+        Ok(unsafe {
+            self.raw_device.allocate_memory(
+                &vk::MemoryAllocateInfo::default()
+                    .push_next(&mut import_info)
+                    .push_next(&mut dedicated_info)
+                    .allocation_size(size)
+                    .memory_type_index(memory_type_index),
+                None,
+            )?
+        })
+    }
+}
+
+impl Drop for Transformer {
+    fn drop(&mut self) {
+        // Everything still in the ring may be referenced by a submission in
+        // flight, wait the device out before tearing the images down.
+        let _ = self.device.poll(wgpu::Maintain::Wait);
+
+        while let Some(it) = self.imported.pop_front() {
+            self.release(it);
+        }
+    }
+}
@@ -0,0 +1,123 @@
+//! Benchmarks of the audio resampler round trip and the chroma interleave
+//! kernels the video resampler feeds the nv12 texture with.
+
+use std::{
+    sync::{
+        Arc,
+        atomic::{AtomicU64, Ordering},
+    },
+    thread,
+    time::{Duration, Instant},
+};
+
+use criterion::{Criterion, Throughput, criterion_group, criterion_main};
+
+use common::frame::{deinterleave_uv, interleave_uv};
+use resample::{
+    AudioResampler, AudioResamplerOutput, AudioSampleDescription, AudioSampleFormat,
+    ThreadedAudioResampler,
+};
+
+// A 20ms capture frame at the typical microphone rate.
+const INPUT_RATE: u32 = 44100;
+const INPUT_FRAMES: usize = INPUT_RATE as usize / 50;
+
+// Counts delivered output buffers, the threaded measurement loop spins on
+// the counter since its conversion happens on the resampler thread.
+struct CountingSink(Arc<AtomicU64>);
+
+impl AudioResamplerOutput<f32> for CountingSink {
+    fn output(&mut self, _buffer: &[f32], _frames: u32) -> bool {
+        self.0.fetch_add(1, Ordering::Relaxed);
+
+        true
+    }
+}
+
+fn descriptions() -> (AudioSampleDescription, AudioSampleDescription) {
+    (
+        AudioSampleDescription {
+            sample_bits: AudioSampleFormat::I16,
+            sample_rate: INPUT_RATE,
+            channels: 2,
+        },
+        AudioSampleDescription {
+            sample_bits: AudioSampleFormat::F32,
+            sample_rate: 48000,
+            channels: 2,
+        },
+    )
+}
+
+fn audio(c: &mut Criterion) {
+    let frame = vec![0i16; INPUT_FRAMES * 2];
+
+    let mut group = c.benchmark_group("audio");
+    group.throughput(Throughput::Elements(INPUT_FRAMES as u64));
+
+    // The synchronous path converts and sinks inline on the calling thread.
+    let (input, output) = descriptions();
+    let outputs = Arc::new(AtomicU64::new(0));
+    let mut resampler: AudioResampler<i16, f32> =
+        AudioResampler::new(input, output, CountingSink(outputs.clone())).unwrap();
+    group.bench_function("resample_20ms_frame", |b| {
+        b.iter(|| resampler.resample(&frame).unwrap())
+    });
+
+    // The threaded path pays the ring handoff and the wakeup on top.
+    let (input, output) = descriptions();
+    let outputs = Arc::new(AtomicU64::new(0));
+    let mut resampler: ThreadedAudioResampler<i16, f32> =
+        ThreadedAudioResampler::new(input, output, CountingSink(outputs.clone())).unwrap();
+    group.bench_function("resample_20ms_frame_threaded", |b| {
+        b.iter_custom(|iters| {
+            let base = outputs.load(Ordering::Relaxed);
+            let started = Instant::now();
+
+            for i in 0..iters {
+                resampler.resample(&frame).unwrap();
+
+                // Keep at most two chunks in flight, a burst faster than the
+                // consumer would just measure ring drops.
+                while outputs.load(Ordering::Relaxed) + 2 < base + i + 1 {
+                    thread::yield_now();
+                }
+            }
+
+            while outputs.load(Ordering::Relaxed) < base + iters {
+                thread::yield_now();
+            }
+
+            started.elapsed()
+        })
+    });
+
+    group.finish();
+}
+
+fn chroma(c: &mut Criterion) {
+    // The chroma planes of a 4k frame.
+    let size = (3840 / 2) * (2160 / 2);
+
+    let u = vec![0x5au8; size];
+    let v = vec![0xa5u8; size];
+    let mut uv = vec![0u8; size * 2];
+
+    let mut group = c.benchmark_group("chroma");
+    group.throughput(Throughput::Bytes((size * 2) as u64));
+    group.measurement_time(Duration::from_secs(10));
+
+    group.bench_function("interleave_uv_4k", |b| {
+        b.iter(|| interleave_uv(&u, &v, &mut uv))
+    });
+
+    let (mut u, mut v) = (u, v);
+    group.bench_function("deinterleave_uv_4k", |b| {
+        b.iter(|| deinterleave_uv(&uv, &mut u, &mut v))
+    });
+
+    group.finish();
+}
+
+criterion_group!(benches, audio, chroma);
+criterion_main!(benches);
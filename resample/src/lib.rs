@@ -1,14 +1,15 @@
 use std::{
+    cell::UnsafeCell,
     marker::PhantomData,
     ptr::null_mut,
     sync::{
         Arc,
-        atomic::{AtomicBool, Ordering},
-        mpsc::{Sender, channel},
+        atomic::{AtomicBool, AtomicUsize, Ordering},
     },
-    thread,
+    thread::{self, JoinHandle, Thread},
 };
 
+use common::scheduler::PipelineRole;
 use ffmpeg::*;
 use thiserror::Error;
 
@@ -59,22 +60,31 @@ pub trait AudioResamplerOutput<T>: Send {
 
 #[derive(Debug, Error)]
 pub enum AudioResamplerError {
-    #[error("failed to send buffer to queue")]
-    SendBufferError,
     #[error("failed to create swresample")]
     CreateSwresampleError,
-    #[error("queue is closed")]
-    QueueClosed,
+    #[error("swresample convert failed")]
+    ConvertError,
+    #[error("resampler is closed")]
+    ClosedError,
 }
 
 /// Audio resampler, quickly resample input to a single channel count and
 /// different sampling rates.
 ///
+/// Resampling a few hundred samples is microseconds of work, so it runs
+/// synchronously on the calling thread into a preallocated buffer, there is
+/// no per-chunk allocation or handoff. The sink is called inline before
+/// [`AudioResampler::resample`] returns. When the caller really cannot
+/// afford the sink running on its thread, see [`ThreadedAudioResampler`].
+///
 /// Note that due to the fast sampling, the quality may be reduced.
 pub struct AudioResampler<I, O> {
-    _p: PhantomData<O>,
-    tx: Sender<Vec<I>>,
-    status: Arc<AtomicBool>,
+    _p: PhantomData<I>,
+    swresample: Swresample,
+    sink: Box<dyn AudioResamplerOutput<O>>,
+    output: Vec<O>,
+    input_channels: usize,
+    closed: bool,
 }
 
 impl<I, O> AudioResampler<I, O>
@@ -85,52 +95,205 @@ where
     pub fn new<T: AudioResamplerOutput<O> + 'static>(
         input: AudioSampleDescription,
         output: AudioSampleDescription,
-        mut sink: T,
+        sink: T,
     ) -> Result<Self, AudioResamplerError> {
-        let (tx, rx) = channel::<Vec<I>>();
+        Ok(Self {
+            swresample: Swresample::new(&input, &output)
+                .ok_or_else(|| AudioResamplerError::CreateSwresampleError)?,
+            // A second worth of output covers any chunk size the capture
+            // backends deliver, allocated once up front.
+            output: vec![O::default(); output.sample_rate as usize * output.channels as usize],
+            input_channels: input.channels as usize,
+            sink: Box::new(sink),
+            _p: PhantomData,
+            closed: false,
+        })
+    }
+
+    /// Resample one chunk in place and hand the result to the sink, all on
+    /// the calling thread. Once the sink has returned false the resampler
+    /// stays closed.
+    pub fn resample<'a>(&'a mut self, buffer: &'a [I]) -> Result<(), AudioResamplerError> {
+        if self.closed {
+            return Err(AudioResamplerError::ClosedError);
+        }
+
+        let frames = buffer.len() / self.input_channels;
+        if !self
+            .swresample
+            .convert(buffer, &mut self.output, frames as i32)
+        {
+            self.closed = true;
+
+            return Err(AudioResamplerError::ConvertError);
+        }
+
+        if !self.sink.output(&self.output, frames as u32) {
+            self.closed = true;
+
+            return Err(AudioResamplerError::ClosedError);
+        }
+
+        Ok(())
+    }
+}
+
+// Single producer single consumer ring of preallocated chunk slots. The
+// producer copies a chunk into the slot at the tail and publishes it by
+// advancing the tail, the consumer drains from the head, so the two sides
+// never touch the same slot and neither ever takes a lock or allocates in
+// steady state.
+struct ChunkRing<I> {
+    slots: Box<[UnsafeCell<Vec<I>>]>,
+    head: AtomicUsize,
+    tail: AtomicUsize,
+    closed: AtomicBool,
+}
+
+unsafe impl<I: Send> Sync for ChunkRing<I> {}
+
+impl<I: Copy> ChunkRing<I> {
+    // A capture backend delivers a chunk every 10-20ms, eight slots absorb
+    // a scheduling hiccup of over 100ms before anything is dropped.
+    const CAPACITY: usize = 8;
+
+    fn new() -> Self {
+        Self {
+            slots: (0..Self::CAPACITY)
+                .map(|_| UnsafeCell::new(Vec::new()))
+                .collect(),
+            head: AtomicUsize::new(0),
+            tail: AtomicUsize::new(0),
+            closed: AtomicBool::new(false),
+        }
+    }
+
+    // Producer side, returns false when the ring is full.
+    fn push(&self, buffer: &[I]) -> bool {
+        let tail = self.tail.load(Ordering::Relaxed);
+        if tail.wrapping_sub(self.head.load(Ordering::Acquire)) == Self::CAPACITY {
+            return false;
+        }
+
+        {
+            let slot = unsafe { &mut *self.slots[tail % Self::CAPACITY].get() };
+            slot.clear();
+            slot.extend_from_slice(buffer);
+        }
+
+        self.tail.store(tail.wrapping_add(1), Ordering::Release);
+        true
+    }
 
-        let status = Arc::new(AtomicBool::new(true));
-        let mut swresample = Swresample::new(&input, &output)
-            .ok_or_else(|| AudioResamplerError::CreateSwresampleError)?;
+    // Consumer side, runs the closure on the chunk at the head and releases
+    // the slot afterwards. Returns false when the ring is empty.
+    fn pop<F: FnMut(&[I])>(&self, mut consume: F) -> bool {
+        let head = self.head.load(Ordering::Relaxed);
+        if head == self.tail.load(Ordering::Acquire) {
+            return false;
+        }
+
+        consume(unsafe { &*self.slots[head % Self::CAPACITY].get() });
+
+        self.head.store(head.wrapping_add(1), Ordering::Release);
+        true
+    }
+}
+
+/// The [`AudioResampler`] behind a lock-free SPSC ring on a dedicated
+/// thread, for callers that cannot afford the sink running inline, e.g. a
+/// sink that blocks on a network send from an OS audio callback.
+///
+/// Chunks are copied into preallocated ring slots, so the steady state has
+/// no allocation and no lock on either side. When the consumer falls more
+/// than the ring capacity behind, the newest chunk is dropped instead of
+/// blocking the caller.
+pub struct ThreadedAudioResampler<I, O> {
+    _p: PhantomData<O>,
+    ring: Arc<ChunkRing<I>>,
+    consumer: Thread,
+    thread: Option<JoinHandle<()>>,
+}
+
+impl<I, O> ThreadedAudioResampler<I, O>
+where
+    I: Copy + Send + 'static,
+    O: Copy + Default + Send + 'static,
+{
+    pub fn new<T: AudioResamplerOutput<O> + 'static>(
+        input: AudioSampleDescription,
+        output: AudioSampleDescription,
+        sink: T,
+    ) -> Result<Self, AudioResamplerError> {
+        let mut resampler = AudioResampler::<I, O>::new(input, output, sink)?;
+
+        let ring: Arc<ChunkRing<I>> = Arc::new(ChunkRing::new());
+        let ring_ = ring.clone();
+        let thread = thread::Builder::new()
+            .name("HylaranaAudioResampleThread".to_string())
+            .spawn(move || {
+                PipelineRole::Audio.apply();
+
+                loop {
+                    let mut failed = false;
+                    if !ring_.pop(|buffer| {
+                        failed = resampler.resample(buffer).is_err();
+                    }) {
+                        if ring_.closed.load(Ordering::Relaxed) {
+                            break;
+                        }
 
-        let status_ = status.clone();
-        thread::spawn(move || {
-            let mut output: Vec<O> =
-                vec![O::default(); output.sample_rate as usize * output.channels as usize];
+                        // The park is the only wakeup mechanism, the producer
+                        // unparks after every publish, a stale unpark just
+                        // costs one spin of the loop.
+                        thread::park();
+                        continue;
+                    }
 
-            while let Ok(buffer) = rx.recv() {
-                let frames = buffer.len() / input.channels as usize;
-                if swresample.convert(&buffer, &mut output, frames as i32) {
-                    if !sink.output(&output, frames as u32) {
+                    if failed {
+                        ring_.closed.store(true, Ordering::Relaxed);
                         break;
                     }
-                } else {
-                    break;
                 }
-            }
-
-            status_.store(false, Ordering::Relaxed);
-        });
+            })
+            .map_err(|_| AudioResamplerError::ClosedError)?;
 
         Ok(Self {
-            _p: PhantomData::default(),
-            status,
-            tx,
+            consumer: thread.thread().clone(),
+            thread: Some(thread),
+            _p: PhantomData,
+            ring,
         })
     }
 
+    /// Hand one chunk to the resampling thread. A full ring drops the chunk
+    /// with a warning instead of blocking, late audio is worse than a
+    /// missing chunk.
     pub fn resample<'a>(&'a mut self, buffer: &'a [I]) -> Result<(), AudioResamplerError> {
-        if !self.status.load(Ordering::Relaxed) {
-            return Err(AudioResamplerError::QueueClosed);
+        if self.ring.closed.load(Ordering::Relaxed) {
+            return Err(AudioResamplerError::ClosedError);
+        }
+
+        if !self.ring.push(buffer) {
+            log::warn!("audio resample ring is full, chunk dropped");
         }
 
-        self.tx
-            .send(buffer.to_vec())
-            .map_err(|_| AudioResamplerError::SendBufferError)?;
+        self.consumer.unpark();
         Ok(())
     }
 }
 
+impl<I, O> Drop for ThreadedAudioResampler<I, O> {
+    fn drop(&mut self) {
+        self.ring.closed.store(true, Ordering::Relaxed);
+        self.consumer.unpark();
+
+        if let Some(thread) = self.thread.take() {
+            let _ = thread.join();
+        }
+    }
+}
+
 struct Swresample(*mut SwrContext);
 
 unsafe impl Send for Swresample {}
@@ -554,12 +717,10 @@ pub mod win32 {
                                 )
                             };
 
-                            let mut index = 0;
-                            for i in 0..data[1].len() {
-                                buffer[index] = data[1][i];
-                                buffer[index + 1] = data[2][i];
-                                index += 2;
-                            }
+                            // The nv12 texture wants the chroma planes packed,
+                            // the simd kernel interleaves them a register at a
+                            // time instead of byte by byte.
+                            common::frame::interleave_uv(data[1], data[2], buffer);
                         }
 
                         unsafe {
@@ -0,0 +1,120 @@
+//! Synthetic end-to-end throughput over a real SRT connection on loopback.
+//!
+//! This goes through everything a frame goes through in production: producer
+//! filter, fragmentation, the socket pair, reassembly, reordering and the
+//! consumer filter. The absolute numbers depend on the host network stack,
+//! what matters is how they move between revisions.
+
+use std::{
+    sync::{
+        Arc,
+        atomic::{AtomicU64, Ordering},
+    },
+    thread,
+    time::{Duration, Instant},
+};
+
+use bytes::Bytes;
+use criterion::{Criterion, Throughput, criterion_group, criterion_main};
+
+use transport::{
+    Buffer, BufferType, StreamType, TransportOptions, TransportReceiver, TransportReceiverSink,
+    TransportSender,
+};
+
+// Frames per measured burst, a second worth of 30fps video.
+const FRAMES: usize = 30;
+
+// Each frame carries a keyframe sized payload, so every burst is fragmented
+// into a few hundred MTU sized packets.
+const FRAME_SIZE: usize = 64 * 1024;
+
+// Counts delivered video payload bytes, the measurement loop spins on the
+// counter until a burst has fully arrived.
+struct CountingSink(Arc<AtomicU64>);
+
+impl TransportReceiverSink for CountingSink {
+    fn sink(&mut self, buffer: Buffer<Bytes>) -> bool {
+        if buffer.stream == StreamType::Video && buffer.ty == BufferType::KeyFrame {
+            self.0
+                .fetch_add(buffer.data.len() as u64, Ordering::Relaxed);
+        }
+
+        true
+    }
+
+    fn close(&mut self) {}
+}
+
+fn video_frame() -> Buffer<bytes::BytesMut> {
+    Buffer {
+        stream: StreamType::Video,
+        track: 0,
+        ty: BufferType::KeyFrame,
+        timestamp: 0,
+        data: Buffer::<()>::copy_from_slice(&vec![0x5a; FRAME_SIZE]),
+    }
+}
+
+fn loopback(c: &mut Criterion) {
+    assert!(transport::startup());
+
+    let sender =
+        TransportSender::new("127.0.0.1:0".parse().unwrap(), TransportOptions::default()).unwrap();
+
+    let received = Arc::new(AtomicU64::new(0));
+    let _receiver = TransportReceiver::new(
+        sender.local_addr(),
+        TransportOptions::default(),
+        CountingSink(received.clone()),
+    )
+    .unwrap();
+
+    // Let the handshake finish, then satisfy the consumer filter, which
+    // discards video until a config buffer has arrived.
+    thread::sleep(Duration::from_millis(100));
+    sender
+        .send(Buffer {
+            stream: StreamType::Video,
+            track: 0,
+            ty: BufferType::Config,
+            timestamp: 0,
+            data: Buffer::<()>::copy_from_slice(&[0x5a; 128]),
+        })
+        .unwrap();
+
+    let mut group = c.benchmark_group("loopback");
+    group.throughput(Throughput::Bytes((FRAMES * FRAME_SIZE) as u64));
+    group.sample_size(20);
+    group.bench_function("video_burst", |b| {
+        b.iter_custom(|iters| {
+            let started = Instant::now();
+
+            for _ in 0..iters {
+                let target = received.load(Ordering::Relaxed) + (FRAMES * FRAME_SIZE) as u64;
+                for _ in 0..FRAMES {
+                    sender.send(video_frame()).unwrap();
+                }
+
+                // SRT may drop under overload, bail out instead of spinning
+                // forever when a burst never fully arrives.
+                let deadline = Instant::now() + Duration::from_secs(10);
+                while received.load(Ordering::Relaxed) < target {
+                    if Instant::now() >= deadline {
+                        panic!("loopback burst did not arrive, link overloaded?");
+                    }
+
+                    thread::yield_now();
+                }
+            }
+
+            started.elapsed()
+        })
+    });
+
+    group.finish();
+    transport::shutdown();
+}
+
+criterion_group!(benches, loopback);
+criterion_main!(benches);
@@ -0,0 +1,187 @@
+//! Micro benchmarks of the transport hot paths with realistic payloads: a
+//! compressed 4k keyframe for the video paths and a 20ms opus frame for the
+//! audio paths, fragmented at the default MTU where fragmentation applies.
+
+use bytes::{Bytes, BytesMut};
+use criterion::{BatchSize, Criterion, Throughput, criterion_group, criterion_main};
+
+use transport::{
+    Buffer, BufferType, StreamType,
+    bench::{FragmentDecoder, FragmentEncoder, StreamConsumer, StreamProducer},
+};
+
+// A 4k keyframe at typical streaming bitrates comes out around this size.
+const KEY_FRAME_SIZE: usize = 256 * 1024;
+
+// A 20ms opus frame at 64kbps.
+const AUDIO_FRAME_SIZE: usize = 160;
+
+const MTU: usize = 1500;
+
+fn video_buffer(ty: BufferType, size: usize) -> Buffer<BytesMut> {
+    Buffer {
+        stream: StreamType::Video,
+        track: 0,
+        ty,
+        timestamp: 0,
+        data: Buffer::<()>::copy_from_slice(&vec![0x5a; size]),
+    }
+}
+
+fn audio_buffer(ty: BufferType) -> Buffer<BytesMut> {
+    Buffer {
+        stream: StreamType::Audio,
+        track: 0,
+        ty,
+        timestamp: 0,
+        data: Buffer::<()>::copy_from_slice(&vec![0x5a; AUDIO_FRAME_SIZE]),
+    }
+}
+
+fn buffer_codec(c: &mut Criterion) {
+    let mut group = c.benchmark_group("buffer");
+
+    group.throughput(Throughput::Bytes(KEY_FRAME_SIZE as u64));
+    group.bench_function("encode_key_frame", |b| {
+        b.iter_batched(
+            || video_buffer(BufferType::KeyFrame, KEY_FRAME_SIZE),
+            |buffer| buffer.encode(0),
+            BatchSize::SmallInput,
+        )
+    });
+
+    let packet = video_buffer(BufferType::KeyFrame, KEY_FRAME_SIZE)
+        .encode(0)
+        .freeze();
+    group.bench_function("decode_key_frame", |b| {
+        b.iter_batched(
+            || packet.clone(),
+            |bytes| Buffer::<Bytes>::decode(bytes).unwrap(),
+            BatchSize::SmallInput,
+        )
+    });
+
+    group.throughput(Throughput::Bytes(AUDIO_FRAME_SIZE as u64));
+    group.bench_function("encode_audio_frame", |b| {
+        b.iter_batched(
+            || audio_buffer(BufferType::Partial),
+            |buffer| buffer.encode(0),
+            BatchSize::SmallInput,
+        )
+    });
+
+    group.finish();
+}
+
+fn fragment_codec(c: &mut Criterion) {
+    let mut group = c.benchmark_group("fragment");
+    group.throughput(Throughput::Bytes(KEY_FRAME_SIZE as u64));
+
+    let packet = video_buffer(BufferType::KeyFrame, KEY_FRAME_SIZE).encode(0);
+    let mut encoder = FragmentEncoder::new(MTU);
+    group.bench_function("encode_key_frame", |b| {
+        let mut batch = Vec::new();
+        b.iter(|| {
+            encoder.encode(&packet, &mut batch);
+            encoder.recycle(&mut batch);
+        })
+    });
+
+    // The decoder releases a message once the first fragment of the next one
+    // arrives, so every iteration feeds the fragments of two messages and
+    // must get exactly one back.
+    let mut fragments = Vec::new();
+    for sequence in 0..2 {
+        let mut batch = Vec::new();
+        encoder.encode(
+            &video_buffer(BufferType::KeyFrame, KEY_FRAME_SIZE).encode(sequence),
+            &mut batch,
+        );
+
+        fragments.extend(batch.into_iter().map(|it| it.freeze()));
+    }
+
+    group.bench_function("decode_key_frame", |b| {
+        b.iter_batched(
+            FragmentDecoder::new,
+            |mut decoder| {
+                let mut packets = 0;
+                for fragment in &fragments {
+                    if decoder.decode(fragment).is_some() {
+                        packets += 1;
+                    }
+                }
+
+                assert_eq!(packets, 1);
+            },
+            BatchSize::SmallInput,
+        )
+    });
+
+    group.finish();
+}
+
+fn stream_filters(c: &mut Criterion) {
+    let mut group = c.benchmark_group("filter");
+
+    group.throughput(Throughput::Bytes(KEY_FRAME_SIZE as u64));
+    let producer = StreamProducer::new(1);
+    producer.filter(video_buffer(BufferType::Config, 128));
+    group.bench_function("produce_key_frame", |b| {
+        b.iter_batched(
+            || video_buffer(BufferType::KeyFrame, KEY_FRAME_SIZE),
+            |buffer| producer.filter(buffer),
+            BatchSize::SmallInput,
+        )
+    });
+
+    group.throughput(Throughput::Bytes(AUDIO_FRAME_SIZE as u64));
+    group.bench_function("produce_audio_frame", |b| {
+        b.iter_batched(
+            || audio_buffer(BufferType::Partial),
+            |buffer| producer.filter(buffer),
+            BatchSize::SmallInput,
+        )
+    });
+
+    // A mid-stream join: the first packets of a gop as a receiver sees them,
+    // config, keyframe and a second worth of deltas, pushed through a fresh
+    // consumer that still has to sync up.
+    let producer = StreamProducer::new(1);
+    let mut gop: Vec<Bytes> = Vec::new();
+    let mut gop_bytes = 0;
+    producer.filter(video_buffer(BufferType::Config, 128));
+    for i in 0..30 {
+        let ty = if i == 0 {
+            BufferType::KeyFrame
+        } else {
+            BufferType::Partial
+        };
+
+        for packet in producer.filter(video_buffer(ty, KEY_FRAME_SIZE / 8)) {
+            gop_bytes += packet.len();
+            gop.push(packet.freeze());
+        }
+    }
+
+    group.throughput(Throughput::Bytes(gop_bytes as u64));
+    group.bench_function("consume_mid_stream_join", |b| {
+        b.iter_batched(
+            StreamConsumer::default,
+            |mut consumer| {
+                let mut buffers = 0;
+                for packet in &gop {
+                    buffers += consumer.filter(packet.clone()).len();
+                }
+
+                assert!(buffers > 0);
+            },
+            BatchSize::SmallInput,
+        )
+    });
+
+    group.finish();
+}
+
+criterion_group!(benches, buffer_codec, fragment_codec, stream_filters);
+criterion_main!(benches);
@@ -1,20 +1,116 @@
-use std::sync::{
-    Arc,
-    atomic::{AtomicU8, AtomicU32, Ordering},
+use std::{
+    sync::{
+        Arc,
+        atomic::{AtomicU8, AtomicU32, Ordering},
+    },
+    time::{Duration, Instant},
 };
 
 use arc_swap::ArcSwapOption;
-use bytes::{Bytes, BytesMut};
+use bytes::{Buf, BufMut, Bytes, BytesMut};
+use parking_lot::Mutex;
 use smallvec::SmallVec;
 
-use crate::{Buffer, BufferType, StreamType};
+use common::metrics::{Counter, Gauge};
+
+use crate::{Buffer, BufferType, MAX_VIDEO_TRACKS, StreamType, TransportReceiverStats, pool};
+
+// Session counters of the receive path, updated by the consumer on the
+// receiver thread and read through [`crate::TransportReceiver::get_stats`].
+#[derive(Default)]
+pub struct ConsumerMetrics {
+    received_packets: Counter,
+    received_bytes: Counter,
+    loss_events: Counter,
+    dropped_packets: Counter,
+    reorder_buffered: Gauge,
+}
+
+impl ConsumerMetrics {
+    pub fn snapshot(&self) -> TransportReceiverStats {
+        TransportReceiverStats {
+            received_packets: self.received_packets.get(),
+            received_bytes: self.received_bytes.get(),
+            loss_events: self.loss_events.get(),
+            dropped_packets: self.dropped_packets.get(),
+            reorder_buffered: self.reorder_buffered.get(),
+        }
+    }
+}
 
 #[derive(Default)]
 struct Configs {
-    video: ArcSwapOption<BytesMut>,
+    // Every video track has its own encoder and therefore its own sps/pps,
+    // the cache is indexed by track.
+    video: [ArcSwapOption<BytesMut>; MAX_VIDEO_TRACKS],
     audio: ArcSwapOption<BytesMut>,
 }
 
+// Coalesces consecutive audio frames into one transport buffer.
+//
+// Every audio frame used to pay the full buffer header, a fragment header and
+// an SRT send on its own, which at 20ms opus frames is 50 tiny packets per
+// second per stream. Each record inside a batch is a u16 payload length and a
+// u64 timestamp followed by the payload, so the consumer can split the batch
+// back into individual frames with their original timestamps intact.
+struct AudioBatcher {
+    frames: usize,
+    count: usize,
+    timestamp: u64,
+    data: Option<BytesMut>,
+}
+
+impl Default for AudioBatcher {
+    fn default() -> Self {
+        Self::new(1)
+    }
+}
+
+impl AudioBatcher {
+    fn new(frames: usize) -> Self {
+        Self {
+            frames: frames.max(1),
+            count: 0,
+            timestamp: 0,
+            data: None,
+        }
+    }
+
+    // Folds one audio frame into the pending batch and returns the batch once
+    // enough frames have accumulated. The frame buffer itself goes back to
+    // the pool, its payload has been copied into the batch.
+    fn push(&mut self, buffer: Buffer<BytesMut>) -> Option<Buffer<BytesMut>> {
+        if self.count == 0 {
+            self.timestamp = buffer.timestamp;
+        }
+
+        let data = self
+            .data
+            .get_or_insert_with(|| Buffer::<()>::with_capacity(0));
+
+        let payload = &buffer.data[Buffer::<()>::HEAD_SIZE..];
+        data.put_u16(payload.len() as u16);
+        data.put_u64(buffer.timestamp);
+        data.extend_from_slice(payload);
+
+        pool::release(buffer.data);
+
+        self.count += 1;
+        if self.count < self.frames {
+            return None;
+        }
+
+        self.count = 0;
+        Some(Buffer {
+            stream: StreamType::Audio,
+            track: 0,
+            ty: BufferType::Batch,
+            timestamp: self.timestamp,
+            data: self.data.take()?,
+        })
+    }
+}
+
 /// Video Audio Streaming Send Processing
 ///
 /// Because the receiver will normally join the stream in the middle of the
@@ -24,34 +120,47 @@ struct Configs {
 pub struct StreamProducer {
     audio_count: AtomicU8,
     sequence: AtomicU32,
+    batcher: Mutex<AudioBatcher>,
     configs: Configs,
 }
 
 impl StreamProducer {
     const AUDIO_INTERVAL: u8 = 50;
 
+    /// Creates a producer that coalesces the given number of audio frames per
+    /// transport packet, 1 disables coalescing.
+    pub fn new(audio_batch: usize) -> Self {
+        Self {
+            batcher: Mutex::new(AudioBatcher::new(audio_batch)),
+            ..Default::default()
+        }
+    }
+
     // h264 decoding any p-frames and i-frames requires sps and pps
     // frames, so the configuration frames are saved here, although it
     // should be noted that the configuration frames will only be
     // generated once.
-    pub fn filter(&self, buffer: Buffer<BytesMut>) -> SmallVec<[Bytes; 2]> {
-        let mut pkts: SmallVec<[Bytes; 2]> = SmallVec::with_capacity(5);
+    pub fn filter(&self, buffer: Buffer<BytesMut>) -> SmallVec<[BytesMut; 2]> {
+        let mut pkts: SmallVec<[BytesMut; 2]> = SmallVec::with_capacity(5);
 
         match buffer.stream {
             StreamType::Video => {
+                // The sender api bounds the track count before anything gets
+                // here, out-of-range indexes just share the last slot.
+                let track = (buffer.track as usize).min(MAX_VIDEO_TRACKS - 1);
+
                 if buffer.ty == BufferType::Config {
-                    self.configs
-                        .video
-                        .store(Some(Arc::new(buffer.data.clone())));
+                    self.configs.video[track].store(Some(Arc::new(buffer.data.clone())));
                 }
 
                 // Add SPS and PPS units in front of each keyframe (only use android)
                 if buffer.ty == BufferType::KeyFrame {
-                    if let Some(cfg) = self.configs.video.load().as_ref() {
+                    if let Some(cfg) = self.configs.video[track].load().as_ref() {
                         pkts.push(
                             Buffer {
-                                data: cfg.as_ref().clone(),
+                                data: clone_config(cfg),
                                 stream: StreamType::Video,
+                                track: buffer.track,
                                 ty: BufferType::Config,
                                 timestamp: buffer.timestamp,
                             }
@@ -76,8 +185,9 @@ impl StreamProducer {
                     if let Some(cfg) = self.configs.audio.load().as_ref() {
                         pkts.push(
                             Buffer {
-                                data: cfg.as_ref().clone(),
+                                data: clone_config(cfg),
                                 stream: StreamType::Audio,
+                                track: 0,
                                 ty: BufferType::Config,
                                 timestamp: buffer.timestamp,
                             }
@@ -86,7 +196,21 @@ impl StreamProducer {
                     }
                 }
 
-                pkts.push(buffer.encode(0));
+                // Configuration packets go out right away, everything else is
+                // offered to the batcher, which either swallows the frame or
+                // hands back a full batch to send.
+                if buffer.ty == BufferType::Config {
+                    pkts.push(buffer.encode(0));
+                } else {
+                    let mut batcher = self.batcher.lock();
+                    if batcher.frames <= 1 {
+                        drop(batcher);
+
+                        pkts.push(buffer.encode(0));
+                    } else if let Some(batch) = batcher.push(buffer) {
+                        pkts.push(batch.encode(0));
+                    }
+                }
             }
         }
 
@@ -94,10 +218,21 @@ impl StreamProducer {
     }
 }
 
+// The cached config buffer is re-sent periodically, copying it into a pooled
+// buffer instead of cloning keeps the keyframe path allocation free.
+fn clone_config(cfg: &BytesMut) -> BytesMut {
+    let mut data = pool::acquire(cfg.len());
+    data.extend_from_slice(cfg);
+    data
+}
+
 struct PacketFilter {
     ty: StreamType,
     initialized: bool,
     readable: bool,
+    // Whether any packet of this stream has arrived at all, distinguishes a
+    // video track that is stalled from one that simply does not exist.
+    seen: bool,
 }
 
 impl PacketFilter {
@@ -105,11 +240,14 @@ impl PacketFilter {
         Self {
             initialized: false,
             readable: false,
+            seen: false,
             ty,
         }
     }
 
     fn filter(&mut self, ty: BufferType) -> bool {
+        self.seen = true;
+
         // First check whether the decoder has been initialized. Here, it is judged
         // whether the configuration information has consumer. If the configuration
         // information has consumer, the decoder initialization is marked as completed.
@@ -152,63 +290,275 @@ impl PacketFilter {
     }
 }
 
+enum ReorderEvent {
+    Packet(Buffer<Bytes>),
+    Loss,
+}
+
+/// Reorder window ahead of the video packet filter.
+///
+/// A single reordered packet used to be treated as loss, which threw a whole
+/// gop away. Out-of-order packets are parked in a small ring indexed by
+/// sequence instead, and a gap is only declared lost after a bounded wait
+/// window has expired. The window is tuned from the observed inter-arrival
+/// jitter (RFC 3550 style smoothing), so a stable link waits almost nothing
+/// while a bursty one gets enough slack for reordering to resolve itself.
+struct ReorderBuffer {
+    ring: Vec<Option<(u32, Buffer<Bytes>)>>,
+    next: Option<u32>,
+    buffered: usize,
+    pending_loss: bool,
+    gap_deadline: Option<Instant>,
+    last_arrival: Option<Instant>,
+    interval: f64,
+    jitter: f64,
+}
+
+impl Default for ReorderBuffer {
+    fn default() -> Self {
+        Self {
+            ring: (0..Self::CAPACITY).map(|_| None).collect(),
+            next: None,
+            buffered: 0,
+            pending_loss: false,
+            gap_deadline: None,
+            last_arrival: None,
+            interval: 0.0,
+            jitter: 0.0,
+        }
+    }
+}
+
+impl ReorderBuffer {
+    const CAPACITY: usize = 64;
+
+    // Bounds for the adaptive wait window.
+    const MIN_WAIT_MS: f64 = 2.0;
+    const MAX_WAIT_MS: f64 = 50.0;
+
+    fn push(&mut self, sequence: u32, buffer: Buffer<Bytes>) {
+        // Update the inter-arrival statistics that drive the wait window.
+        let now = Instant::now();
+        if let Some(last) = self.last_arrival.replace(now) {
+            let delta = (now - last).as_secs_f64() * 1000.0;
+            self.jitter += ((delta - self.interval).abs() - self.jitter) / 8.0;
+            self.interval += (delta - self.interval) / 8.0;
+        }
+
+        let next = *self.next.get_or_insert(sequence);
+        let distance = sequence.wrapping_sub(next);
+
+        // Late duplicates of something already delivered or given up on.
+        if distance > u32::MAX / 2 {
+            return;
+        }
+
+        // The packet is so far ahead that the window cannot bridge the gap,
+        // everything in between is as good as lost.
+        if distance as usize >= Self::CAPACITY {
+            for slot in self.ring.iter_mut() {
+                *slot = None;
+            }
+
+            self.buffered = 0;
+            self.pending_loss = true;
+            self.next = Some(sequence);
+            self.gap_deadline = None;
+        }
+
+        let slot = &mut self.ring[sequence as usize % Self::CAPACITY];
+        if slot.is_none() {
+            self.buffered += 1;
+        }
+
+        slot.replace((sequence, buffer));
+    }
+
+    fn next_ready(&mut self) -> Option<ReorderEvent> {
+        if self.pending_loss {
+            self.pending_loss = false;
+
+            return Some(ReorderEvent::Loss);
+        }
+
+        let next = self.next?;
+        let slot = &mut self.ring[next as usize % Self::CAPACITY];
+        if let Some((sequence, _)) = slot {
+            if *sequence == next {
+                let (_, buffer) = slot.take()?;
+
+                self.buffered -= 1;
+                self.next = Some(next.wrapping_add(1));
+                self.gap_deadline = None;
+
+                return Some(ReorderEvent::Packet(buffer));
+            }
+        }
+
+        // Nothing newer is parked, this is not a gap, just the stream
+        // position, keep waiting for the network.
+        if self.buffered == 0 {
+            return None;
+        }
+
+        let now = Instant::now();
+        if let Some(deadline) = self.gap_deadline {
+            if now >= deadline {
+                // The window expired, skip to the oldest packet that did
+                // arrive and report the gap as loss.
+                self.gap_deadline = None;
+                self.next = self
+                    .ring
+                    .iter()
+                    .flatten()
+                    .map(|(sequence, _)| *sequence)
+                    .min_by_key(|sequence| sequence.wrapping_sub(next));
+
+                return Some(ReorderEvent::Loss);
+            }
+        } else {
+            let wait = (self.jitter * 4.0).clamp(Self::MIN_WAIT_MS, Self::MAX_WAIT_MS);
+            self.gap_deadline = Some(now + Duration::from_secs_f64(wait / 1000.0));
+        }
+
+        None
+    }
+}
+
 /// Video Audio Streaming Receiver Processing
 ///
 /// The main purpose is to deal with cases where packet loss occurs at the
 /// receiver side, since the SRT communication protocol does not completely
 /// guarantee no packet loss.
 pub struct StreamConsumer {
-    last_sequence: Option<u32>,
-    video: PacketFilter,
+    reorder: ReorderBuffer,
+    video: [PacketFilter; MAX_VIDEO_TRACKS],
     audio: PacketFilter,
+    metrics: Arc<ConsumerMetrics>,
 }
 
 impl Default for StreamConsumer {
     fn default() -> Self {
+        Self::new(Default::default())
+    }
+}
+
+impl StreamConsumer {
+    /// Creates a consumer that reports its receive path counters through the
+    /// given shared metrics.
+    pub fn new(metrics: Arc<ConsumerMetrics>) -> Self {
         Self {
-            video: PacketFilter::new(StreamType::Video),
+            video: std::array::from_fn(|_| PacketFilter::new(StreamType::Video)),
             audio: PacketFilter::new(StreamType::Audio),
-            last_sequence: None,
+            reorder: ReorderBuffer::default(),
+            metrics,
         }
     }
-}
 
-impl StreamConsumer {
     /// As soon as a keyframe is received, the keyframe is cached, and when a
     /// packet loss occurs, the previous keyframe is retransmitted directly into
     /// the decoder.
-    pub fn filter(&mut self, bytes: Bytes) -> Option<Buffer<Bytes>> {
+    ///
+    /// A single input packet can release several buffered ones once it fills
+    /// a reordering gap, so the result is a list.
+    pub fn filter(&mut self, bytes: Bytes) -> SmallVec<[Buffer<Bytes>; 2]> {
+        let mut output: SmallVec<[Buffer<Bytes>; 2]> = SmallVec::new();
+
+        self.metrics.received_bytes.add(bytes.len() as u64);
+
         // Decode the data packet to get sequence number and buffer information
-        let (sequence, buffer) = Buffer::<Bytes>::decode(bytes).ok()?;
+        let (sequence, buffer) = match Buffer::<Bytes>::decode(bytes) {
+            Ok(it) => it,
+            Err(_) => return output,
+        };
+
+        self.metrics.received_packets.inc();
 
         match buffer.stream {
             StreamType::Video => {
-                // If there is a previous sequence number, perform packet loss detection
-                if let Some(last) = self.last_sequence.replace(sequence) {
-                    // Check if sequence numbers are consecutive, if not, packet loss is detected
-                    if sequence != last.wrapping_add(1) {
-                        // Mark video stream as unreadable and wait for next keyframe
-                        self.video.pkt_loss();
+                // Park the packet in the reorder window and deliver whatever
+                // has become consecutive.
+                self.reorder.push(sequence, buffer);
 
-                        log::warn!("packet loss occurs at the transport layer");
+                while let Some(event) = self.reorder.next_ready() {
+                    match event {
+                        ReorderEvent::Packet(buffer) => {
+                            // Filter packets based on their type
+                            let track = (buffer.track as usize).min(MAX_VIDEO_TRACKS - 1);
+                            if self.video[track].filter(buffer.ty) {
+                                output.push(buffer);
+                            } else {
+                                self.metrics.dropped_packets.inc();
+                            }
+                        }
+                        ReorderEvent::Loss => {
+                            self.metrics.loss_events.inc();
 
-                        return None;
+                            // All video tracks share one sequence space, a gap
+                            // cannot be attributed to a single track, so every
+                            // track waits for its next keyframe.
+                            for filter in self.video.iter_mut() {
+                                filter.pkt_loss();
+                            }
+
+                            log::warn!("packet loss occurs at the transport layer");
+                        }
                     }
                 }
 
-                // Filter packets based on their type
-                if self.video.filter(buffer.ty) {
-                    return Some(buffer);
-                }
+                self.metrics
+                    .reorder_buffered
+                    .set(self.reorder.buffered as u64);
             }
             StreamType::Audio => {
                 // Audio stream only needs type-based filtering
                 if self.audio.filter(buffer.ty) {
-                    return Some(buffer);
+                    if buffer.ty == BufferType::Batch {
+                        // A coalesced batch is split back into individual
+                        // frames here, the slices are zero-copy views into
+                        // the batch payload.
+                        let mut data = buffer.data;
+                        while data.remaining() >= 10 {
+                            let size = data.get_u16() as usize;
+                            let timestamp = data.get_u64();
+                            if data.remaining() < size {
+                                break;
+                            }
+
+                            output.push(Buffer {
+                                stream: StreamType::Audio,
+                                track: 0,
+                                ty: BufferType::Partial,
+                                data: data.split_to(size),
+                                timestamp,
+                            });
+                        }
+                    } else {
+                        output.push(buffer);
+                    }
+                } else {
+                    self.metrics.dropped_packets.inc();
                 }
             }
         }
 
-        None
+        output
+    }
+
+    /// Bitmask of the video tracks currently being discarded while waiting
+    /// for a keyframe, either because this consumer just joined mid-stream or
+    /// because packet loss flushed them.
+    pub fn waiting_for_key_frame(&self) -> u8 {
+        let mut mask = 0;
+        for (track, filter) in self.video.iter().enumerate() {
+            // Only track 0 is assumed to exist before any traffic has
+            // arrived, the other tracks are requested once a packet has
+            // proven they are there.
+            if !filter.readable && (track == 0 || filter.seen) {
+                mask |= 1 << track;
+            }
+        }
+
+        mask
     }
 }
@@ -1,6 +1,17 @@
 mod filter;
+mod pool;
 mod protocol;
 
+// The targets under `benches/` exercise internals that are not part of the
+// public API, this facade hands them out to the bench harness only.
+#[doc(hidden)]
+pub mod bench {
+    pub use super::{
+        filter::{StreamConsumer, StreamProducer},
+        protocol::{FragmentDecoder, FragmentEncoder},
+    };
+}
+
 use std::io::{Error, ErrorKind, Result};
 
 use bytes::{Buf, BufMut, Bytes, BytesMut};
@@ -28,6 +39,11 @@ pub struct TransportOptions {
     pub fec: String,
     // Flow control window size
     pub fc: u32,
+    // Number of audio frames coalesced into one transport packet, 1 disables
+    // coalescing. Each coalesced frame adds one frame duration of latency but
+    // removes a full header + send round, which matters on relay hosts moving
+    // many streams.
+    pub audio_batch: u32,
 }
 
 impl Default for TransportOptions {
@@ -39,10 +55,82 @@ impl Default for TransportOptions {
             latency: 20,
             mtu: 1500,
             fc: 32,
+            audio_batch: 1,
         }
     }
 }
 
+/// Runtime statistics of the sender side SRT connection.
+///
+/// Interval counters (packets sent/lost/retransmitted) are reset every time a
+/// snapshot is taken, so each snapshot describes the window since the
+/// previous one.
+#[derive(Debug, Default, Clone, Copy)]
+pub struct TransportSenderStats {
+    /// Smoothed round-trip time in milliseconds.
+    pub rtt_ms: f64,
+    /// Estimated link bandwidth in megabits per second.
+    pub bandwidth_mbps: f64,
+    /// Current sending rate in megabits per second.
+    pub send_rate_mbps: f64,
+    /// Milliseconds worth of unacknowledged data in the send buffer.
+    pub send_buffer_ms: u32,
+    /// Packets reported lost by the receiver in the last window.
+    pub lost_packets: u64,
+    /// Packets retransmitted in the last window.
+    pub retransmitted_packets: u64,
+    /// Packets sent in the last window.
+    pub sent_packets: u64,
+}
+
+impl TransportSenderStats {
+    /// Ratio of lost to sent packets in the last window, between 0.0 and 1.0.
+    pub fn loss_rate(&self) -> f64 {
+        if self.sent_packets == 0 {
+            0.0
+        } else {
+            (self.lost_packets as f64 / self.sent_packets as f64).min(1.0)
+        }
+    }
+}
+
+/// Runtime statistics of the receiver side of a transport session.
+///
+/// Unlike the sender statistics these are session counters, they accumulate
+/// from the moment the connection was established and never reset, so a
+/// scraper can diff consecutive snapshots at whatever interval it likes.
+/// Updating them is a relaxed atomic increment on the receive path, cheap
+/// enough to stay on unconditionally.
+#[derive(Debug, Default, Clone, Copy)]
+pub struct TransportReceiverStats {
+    /// Packets decoded off the socket.
+    pub received_packets: u64,
+    /// Payload bytes decoded off the socket, headers included.
+    pub received_bytes: u64,
+    /// Gaps the reorder window gave up on and reported as loss.
+    pub loss_events: u64,
+    /// Packets the stream filters discarded, mostly video packets thrown
+    /// away while a track waits for its next keyframe.
+    pub dropped_packets: u64,
+    /// Packets currently parked in the reorder window.
+    pub reorder_buffered: u64,
+}
+
+// Control message sent by a receiver over the reverse direction of its SRT
+// socket to ask the sender for an immediate keyframe. A data fragment always
+// carries at least an 8-byte header plus payload, so a 4-byte message can
+// never be mistaken for one. The third byte carries the video track index the
+// request is for, 0 for a single-track stream.
+const KEY_FRAME_REQUEST: [u8; 4] = [0xab, 0x01, 0x00, 0x00];
+
+/// Upper bound on the number of video tracks multiplexed over one connection.
+///
+/// Several capture sources can share a single sender, each one as its own
+/// video track with its own encoder and config. The bound keeps the per-track
+/// state on both sides small and fixed, and lets the keyframe request
+/// backchannel address a track with a bit in a byte.
+pub const MAX_VIDEO_TRACKS: usize = 4;
+
 /// Initialize the SRT communication protocol, mainly initializing some
 /// log-related things.
 pub fn startup() -> bool {
@@ -61,6 +149,7 @@ pub enum BufferType {
     Partial = 0,  // Represents a partial frame or incomplete data
     KeyFrame = 1, // Represents a complete key frame in video streaming
     Config = 2,   // Represents configuration data
+    Batch = 3,    // Several coalesced audio frames with per-frame timestamps
 }
 
 impl TryFrom<u8> for BufferType {
@@ -71,6 +160,7 @@ impl TryFrom<u8> for BufferType {
             0 => Self::Partial,
             1 => Self::KeyFrame,
             2 => Self::Config,
+            3 => Self::Batch,
             _ => {
                 return Err(Error::new(
                     ErrorKind::InvalidInput,
@@ -110,6 +200,7 @@ impl TryFrom<u8> for StreamType {
 #[derive(Debug, Clone)]
 pub struct Buffer<T> {
     pub stream: StreamType, // Type of stream (video/audio)
+    pub track: u8,          // Video track index, always 0 for audio
     pub ty: BufferType,     // Type of buffer (keyframe/config/etc)
     pub timestamp: u64,     // Timestamp for synchronization
     pub data: T,            // The actual data payload
@@ -117,13 +208,16 @@ pub struct Buffer<T> {
 
 impl<T> Buffer<T> {
     /// Size of the header in bytes for each buffer
-    const HEAD_SIZE: usize = 14;
+    const HEAD_SIZE: usize = 15;
 
     /// Creates a BytesMut and copies from src to a buffer. The created buffer
     /// contains the initial message header required for message encoding, which
     /// is an optimization to reduce data copying in the process.
+    ///
+    /// The buffer comes from a recycling pool, so in the steady state no heap
+    /// allocation happens here, see the `pool` module.
     pub fn copy_from_slice(src: &[u8]) -> BytesMut {
-        let mut bytes = BytesMut::with_capacity(src.len() + Self::HEAD_SIZE);
+        let mut bytes = pool::acquire(src.len() + Self::HEAD_SIZE);
         bytes.put_bytes(0, Self::HEAD_SIZE);
         bytes.put(src);
         bytes
@@ -133,15 +227,27 @@ impl<T> Buffer<T> {
     /// created buffer contains the initialization message header required
     /// for message encoding, which is an optimization to reduce data
     /// copying in the process.
+    ///
+    /// The buffer comes from a recycling pool, so in the steady state no heap
+    /// allocation happens here, see the `pool` module.
     pub fn with_capacity(size: usize) -> BytesMut {
-        BytesMut::zeroed(size + Self::HEAD_SIZE)
+        let mut bytes = pool::acquire(size + Self::HEAD_SIZE);
+        bytes.resize(size + Self::HEAD_SIZE, 0);
+        bytes
     }
 }
 
 impl Buffer<BytesMut> {
     /// Encodes the buffer into a network packet format
     /// The result may be null if an empty packet is passed in
-    pub(crate) fn encode(mut self, sequence: u32) -> Bytes {
+    ///
+    /// The buffer stays mutable instead of being frozen so it can be returned
+    /// to the buffer pool once the fragments have been handed to the socket.
+    ///
+    /// Public only so the bench targets can exercise it, not part of the
+    /// supported API.
+    #[doc(hidden)]
+    pub fn encode(mut self, sequence: u32) -> BytesMut {
         let size = self.data.len();
 
         // Temporarily clear the buffer to write header
@@ -152,6 +258,7 @@ impl Buffer<BytesMut> {
         // Write header information
         self.data.put_u32(sequence);
         self.data.put_u8(self.stream as u8);
+        self.data.put_u8(self.track);
         self.data.put_u8(self.ty as u8);
         self.data.put_u64(self.timestamp);
 
@@ -160,18 +267,23 @@ impl Buffer<BytesMut> {
             self.data.set_len(size);
         }
 
-        self.data.freeze()
+        self.data
     }
 }
 
 impl Buffer<Bytes> {
     /// Decodes network packets into Buffer structure
     /// Separates different types of data and validates the packet format
-    pub(crate) fn decode(mut bytes: Bytes) -> Result<(u32, Buffer<Bytes>)> {
+    ///
+    /// Public only so the bench targets can exercise it, not part of the
+    /// supported API.
+    #[doc(hidden)]
+    pub fn decode(mut bytes: Bytes) -> Result<(u32, Buffer<Bytes>)> {
         Ok((
             bytes.get_u32(),
             Buffer {
                 stream: StreamType::try_from(bytes.get_u8())?,
+                track: bytes.get_u8(),
                 ty: BufferType::try_from(bytes.get_u8())?,
                 timestamp: bytes.get_u64(),
                 data: bytes,
@@ -181,16 +293,26 @@ impl Buffer<Bytes> {
 }
 
 mod receiver {
-    use std::{io::Error, net::SocketAddr, sync::Arc, thread};
+    use std::{
+        io::Error,
+        net::SocketAddr,
+        sync::Arc,
+        thread,
+        time::{Duration, Instant},
+    };
 
     use bytes::Bytes;
 
     use super::{
-        Buffer, TransportOptions,
-        filter::StreamConsumer,
-        protocol::{FragmentDecoder, SrtOptions, SrtSocket},
+        Buffer, KEY_FRAME_REQUEST, MAX_VIDEO_TRACKS, TransportOptions, TransportReceiverStats,
+        filter::{ConsumerMetrics, StreamConsumer},
+        protocol::{FragmentDecoder, RecvArena, SrtOptions, SrtSocket},
     };
 
+    // Minimum interval between two keyframe requests, so a receiver that is
+    // stuck for a while does not flood the backchannel.
+    const KEY_FRAME_REQUEST_INTERVAL: Duration = Duration::from_millis(500);
+
     /// Trait for handling received data
     pub trait ReceiverSink: Send {
         /// Process received buffer data
@@ -203,6 +325,7 @@ mod receiver {
     /// Handles receiving data over SRT protocol
     pub struct Receiver {
         socket: Arc<SrtSocket>,
+        metrics: Arc<ConsumerMetrics>,
     }
 
     impl Receiver {
@@ -221,35 +344,85 @@ mod receiver {
                 opt.max_bandwidth = options.max_bandwidth;
                 opt.timeout = options.timeout;
                 opt.latency = options.latency;
-                opt.fec = options.fec;
                 opt.mtu = options.mtu;
                 opt.fc = options.fc;
 
+                // The receiver leaves the packet filter unset and adopts
+                // whatever geometry the sender's listener dictates during the
+                // handshake, otherwise the sender could never retune FEC
+                // without every receiver being reconfigured in lockstep.
+                opt.fec = String::new();
+
                 opt
             })?);
 
+            // The consumer updates the counters on the receiver thread, the
+            // handle keeps a second reference for snapshots.
+            let metrics: Arc<ConsumerMetrics> = Default::default();
+
             // Spawn receiver thread
             let socket_ = socket.clone();
+            let metrics_ = metrics.clone();
             thread::Builder::new()
                 .name("HylaranaTransportReceiverThread".to_string())
                 .spawn(move || {
-                    let mut bytes = [0u8; 4096];
-                    let mut decoder = FragmentDecoder::new();
-                    let mut consumer = StreamConsumer::default();
+                    common::scheduler::PipelineRole::Network.apply();
 
-                    // Main receive loop
-                    loop {
-                        match socket_.read(&mut bytes) {
-                            Ok(size) => {
-                                if size == 0 {
+                    let mut arena = RecvArena::default();
+                    let mut decoder = FragmentDecoder::new();
+                    let mut consumer = StreamConsumer::new(metrics_);
+                    let mut last_request: Option<Instant> = None;
+
+                    // Main receive loop, each wakeup drains everything that
+                    // has queued up on the socket and feeds the decoder the
+                    // whole burst, which amortizes the per-packet overhead.
+                    'a: loop {
+                        match socket_.read_batch(&mut arena) {
+                            Ok(count) => {
+                                if count == 0 {
                                     break;
                                 }
 
                                 // Process received data
-                                if let Some(packet) = decoder.decode(&bytes[..size]) {
-                                    if let Some(buffer) = consumer.filter(packet) {
-                                        if !sinker.sink(buffer) {
-                                            break;
+                                for message in arena.iter() {
+                                    if let Some(packet) = decoder.decode(message) {
+                                        // Filling a reordering gap can release
+                                        // several buffers at once.
+                                        for buffer in consumer.filter(packet) {
+                                            if !sinker.sink(buffer) {
+                                                break 'a;
+                                            }
+                                        }
+                                    }
+                                }
+
+                                // A video track is stalled waiting for a
+                                // keyframe, either because this receiver just
+                                // joined mid-stream or because loss flushed
+                                // it. Ask the sender for an immediate one per
+                                // stalled track instead of waiting out the
+                                // keyframe interval.
+                                let waiting = consumer.waiting_for_key_frame();
+                                if waiting != 0
+                                    && last_request
+                                        .map(|it| it.elapsed() >= KEY_FRAME_REQUEST_INTERVAL)
+                                        .unwrap_or(true)
+                                {
+                                    last_request = Some(Instant::now());
+
+                                    for track in 0..MAX_VIDEO_TRACKS as u8 {
+                                        if waiting & (1 << track) == 0 {
+                                            continue;
+                                        }
+
+                                        let mut request = KEY_FRAME_REQUEST;
+                                        request[2] = track;
+
+                                        if let Err(e) = socket_.send(&request) {
+                                            log::warn!(
+                                                "transport failed to send key frame request, err={:?}",
+                                                e
+                                            );
                                         }
                                     }
                                 }
@@ -266,7 +439,15 @@ mod receiver {
                     sinker.close();
                 })?;
 
-            Ok(Self { socket })
+            Ok(Self { socket, metrics })
+        }
+
+        /// Takes a snapshot of the receive path counters.
+        ///
+        /// The counters accumulate over the whole session, a scraper diffs
+        /// consecutive snapshots at whatever interval suits it.
+        pub fn get_stats(&self) -> TransportReceiverStats {
+            self.metrics.snapshot()
         }
     }
 
@@ -281,31 +462,242 @@ mod receiver {
 
 mod sender {
     use std::{
+        cell::RefCell,
+        collections::VecDeque,
         io::{Error, ErrorKind, Result},
         net::SocketAddr,
         sync::{
             Arc,
-            atomic::{AtomicBool, Ordering},
+            atomic::{AtomicBool, AtomicU8, Ordering},
         },
         thread,
     };
 
-    use arc_swap::ArcSwapOption;
-    use bytes::BytesMut;
-    use parking_lot::Mutex;
+    use bytes::{Bytes, BytesMut};
+    use parking_lot::{Condvar, Mutex};
 
     use super::{
-        Buffer, TransportOptions,
+        Buffer, BufferType, KEY_FRAME_REQUEST, MAX_VIDEO_TRACKS, StreamType, TransportOptions,
+        TransportSenderStats,
         filter::StreamProducer,
-        protocol::{FragmentEncoder, SRT_TRACEBSTATS, SrtOptions, SrtServer, SrtSocket},
+        protocol::{
+            FragmentEncoder, FragmentFreelist, SRT_TRACEBSTATS, SrtOptions, SrtServer, SrtSocket,
+        },
     };
 
+    // Upper bound on simultaneously connected subscribers, also the listen
+    // backlog of the SRT server. One capture and encode session fans out to
+    // at most this many viewers.
+    const MAX_SUBSCRIBERS: usize = 16;
+
+    // Bounded depth of a subscriber queue, in fragmented messages. At common
+    // frame rates this is around a second of backlog, a consumer that falls
+    // further behind than that is stale anyway and gets dropped back to the
+    // next keyframe instead of growing the queue without bound.
+    const SUBSCRIBER_QUEUE_LIMIT: usize = 64;
+
+    // Loss-aware FEC geometry control.
+    //
+    // On clean links the static staircase filter is pure overhead, on lossy
+    // ones it is too weak. The controller smoothes the measured loss ratio
+    // and picks a geometry band for it: no FEC at all, the light default, or
+    // a dense staircase. Because the packet filter is negotiated during the
+    // SRT handshake, live connections keep what they have; the new geometry
+    // is applied to the listening socket and takes effect on the next
+    // accepted connection (a new subscriber or a reconnect).
+    struct FecController {
+        loss: f64,
+        band: usize,
+    }
+
+    impl Default for FecController {
+        fn default() -> Self {
+            // Starts in the band matching `TransportOptions::default()`.
+            Self { loss: 0.0, band: 1 }
+        }
+    }
+
+    impl FecController {
+        const CONFIGS: [&'static str; 3] = [
+            "",
+            "fec,layout:staircase,rows:2,cols:10,arq:onreq",
+            "fec,layout:staircase,rows:5,cols:10,arq:onreq",
+        ];
+
+        // Feeds one loss measurement in and returns the new FEC configuration
+        // if the smoothed loss crossed into another band.
+        fn update(&mut self, loss_rate: f64) -> Option<&'static str> {
+            self.loss = self.loss * 0.7 + loss_rate * 0.3;
+
+            let band = if self.loss < 0.005 {
+                0
+            } else if self.loss < 0.05 {
+                1
+            } else {
+                2
+            };
+
+            if band != self.band {
+                self.band = band;
+
+                Some(Self::CONFIGS[band])
+            } else {
+                None
+            }
+        }
+    }
+
+    // One fragmented wire message, shared by reference between the
+    // subscriber queues so fan-out never copies payload bytes.
+    //
+    // The tag mirrors the buffer the message was produced from. The config
+    // the producer injects in front of a keyframe therefore travels under
+    // the keyframe's own tag, which is exactly what the drop policy needs:
+    // everything required to resynchronize a stalled track passes as one
+    // group.
+    struct SendPacket {
+        fragments: Vec<Bytes>,
+        freelist: FragmentFreelist,
+        stream: StreamType,
+        ty: BufferType,
+        track: u8,
+    }
+
+    impl Drop for SendPacket {
+        fn drop(&mut self) {
+            // The last queue to let go of the packet owns the only reference
+            // to each fragment, so the storage goes back to the encoder
+            // freelist and steady-state fan-out stays allocation free.
+            for fragment in self.fragments.drain(..) {
+                self.freelist.release(fragment);
+            }
+        }
+    }
+
+    #[derive(Default)]
+    struct QueueState {
+        messages: VecDeque<Arc<SendPacket>>,
+        // One bit per video track that is muted until its next keyframe,
+        // set when this subscriber joins mid-stream or overflows its queue.
+        waiting: u8,
+        closed: bool,
+    }
+
+    // Bounded mailbox between the encode threads and one subscriber's
+    // writer thread, with the slow-consumer policy built into the push side.
+    struct SubscriberQueue {
+        state: Mutex<QueueState>,
+        available: Condvar,
+        // Shared with the sender, an overflow asks the encoders for fresh
+        // keyframes the same way a receiver backchannel request does.
+        key_frame_request: Arc<AtomicU8>,
+    }
+
+    impl SubscriberQueue {
+        const ALL_TRACKS: u8 = (1 << MAX_VIDEO_TRACKS) - 1;
+
+        fn new(key_frame_request: Arc<AtomicU8>) -> Self {
+            // A subscriber joining mid-stream cannot decode anything before
+            // a keyframe, start muted on every video track and ask the
+            // encoders for one right away instead of shipping partial
+            // frames the peer can only throw away.
+            key_frame_request.fetch_or(Self::ALL_TRACKS, Ordering::Relaxed);
+
+            Self {
+                state: Mutex::new(QueueState {
+                    waiting: Self::ALL_TRACKS,
+                    ..Default::default()
+                }),
+                available: Condvar::new(),
+                key_frame_request,
+            }
+        }
+
+        // Queues one message for the writer thread. A full queue means the
+        // link or the peer is slower than the stream and everything queued
+        // is stale: drop it all, mute video until the next keyframe and ask
+        // the encoders for one immediately. Returns `false` once the
+        // subscriber is gone and should be pruned.
+        fn push(&self, packet: Arc<SendPacket>) -> bool {
+            let mut state = self.state.lock();
+            if state.closed {
+                return false;
+            }
+
+            if state.messages.len() >= SUBSCRIBER_QUEUE_LIMIT {
+                log::warn!("transport subscriber queue overflow, dropping to next key frame");
+
+                state.messages.clear();
+                state.waiting = Self::ALL_TRACKS;
+
+                self.key_frame_request
+                    .fetch_or(Self::ALL_TRACKS, Ordering::Relaxed);
+            }
+
+            if packet.stream == StreamType::Video {
+                let mask = 1u8 << (packet.track as usize % MAX_VIDEO_TRACKS);
+                if state.waiting & mask != 0 {
+                    match packet.ty {
+                        BufferType::KeyFrame => state.waiting &= !mask,
+                        // Configs are never dropped, the decoder cannot
+                        // start without them.
+                        BufferType::Config => {}
+                        _ => return true,
+                    }
+                }
+            }
+
+            state.messages.push_back(packet);
+            drop(state);
+
+            self.available.notify_one();
+            true
+        }
+
+        // Blocks the writer thread until a message or the end of the
+        // subscription, whichever comes first.
+        fn pop(&self) -> Option<Arc<SendPacket>> {
+            let mut state = self.state.lock();
+            loop {
+                if let Some(packet) = state.messages.pop_front() {
+                    return Some(packet);
+                }
+
+                if state.closed {
+                    return None;
+                }
+
+                self.available.wait(&mut state);
+            }
+        }
+
+        fn close(&self) {
+            self.state.lock().closed = true;
+            self.available.notify_all();
+        }
+
+        fn is_closed(&self) -> bool {
+            self.state.lock().closed
+        }
+    }
+
+    // One connected receiver: its socket plus the queue its writer thread
+    // drains.
+    struct Subscriber {
+        addr: SocketAddr,
+        socket: Arc<SrtSocket>,
+        queue: Arc<SubscriberQueue>,
+    }
+
     /// Handles sending data over SRT protocol
     pub struct Sender {
         working: Arc<AtomicBool>,
         producer: StreamProducer,
         encoder: Mutex<FragmentEncoder>,
-        socket: Arc<ArcSwapOption<SrtSocket>>,
+        freelist: FragmentFreelist,
+        fec: Mutex<FecController>,
+        key_frame_request: Arc<AtomicU8>,
+        subscribers: Arc<Mutex<Vec<Arc<Subscriber>>>>,
         server: Arc<SrtServer>,
         address: SocketAddr,
     }
@@ -317,7 +709,7 @@ mod sender {
             log::info!("transport create sender, bind={}", bind);
 
             let working = Arc::new(AtomicBool::new(true));
-            let socket: Arc<ArcSwapOption<SrtSocket>> = Default::default();
+            let subscribers: Arc<Mutex<Vec<Arc<Subscriber>>>> = Default::default();
 
             // Initialize SRT server with optimized settings
             let server = Arc::new(SrtServer::bind(
@@ -333,28 +725,125 @@ mod sender {
 
                     opt
                 },
-                1,
+                MAX_SUBSCRIBERS as u32,
             )?);
 
             let address = server
                 .local_addr()
                 .ok_or_else(|| Error::new(ErrorKind::AddrNotAvailable, ""))?;
 
+            // One bit per video track, set when a receiver asked for an
+            // immediate keyframe on that track.
+            let key_frame_request: Arc<AtomicU8> = Default::default();
+
             // Spawn server thread for connection handling
             let working_ = working.clone();
             let server_ = server.clone();
-            let socket_ = Arc::downgrade(&socket);
+            let subscribers_ = Arc::downgrade(&subscribers);
+            let key_frame_request_ = key_frame_request.clone();
             thread::Builder::new()
                 .name("HylaranaTransportSenderThread".to_string())
                 .spawn(move || {
                     while let Ok((socket, addr)) = server_.accept() {
-                        if let Some(srt_socket) = socket_.upgrade() {
-                            srt_socket.store(Some(Arc::new(socket)));
-
-                            log::info!("transport srt server accept a socket, addr={}", addr);
-                        } else {
+                        let Some(subscribers) = subscribers_.upgrade() else {
                             break;
+                        };
+
+                        let socket = Arc::new(socket);
+
+                        let queue = {
+                            let mut subscribers = subscribers.lock();
+
+                            // Subscribers whose writer already shut down are
+                            // only pruned when traffic flows, sweep them here
+                            // too so an idle slot can be reused.
+                            subscribers.retain(|it| !it.queue.is_closed());
+
+                            if subscribers.len() >= MAX_SUBSCRIBERS {
+                                log::warn!(
+                                    "transport subscriber limit reached, rejecting addr={}",
+                                    addr
+                                );
+
+                                continue;
+                            }
+
+                            let queue = Arc::new(SubscriberQueue::new(key_frame_request_.clone()));
+                            subscribers.push(Arc::new(Subscriber {
+                                socket: socket.clone(),
+                                queue: queue.clone(),
+                                addr,
+                            }));
+
+                            queue
+                        };
+
+                        // Each subscriber gets its own writer thread, a slow
+                        // or lossy peer backs up only its own queue, never
+                        // the encode path or the other subscribers.
+                        {
+                            let socket = socket.clone();
+                            let queue = queue.clone();
+                            let _ = thread::Builder::new()
+                                .name("HylaranaTransportSubscriberThread".to_string())
+                                .spawn(move || {
+                                    common::scheduler::PipelineRole::Network.apply();
+
+                                    'a: while let Some(packet) = queue.pop() {
+                                        for fragment in &packet.fragments {
+                                            if let Err(e) = socket.send(fragment) {
+                                                log::warn!(
+                                                    "transport failed to send data to \
+                                                    subscriber, addr={}, err={:?}",
+                                                    addr,
+                                                    e
+                                                );
+
+                                                break 'a;
+                                            }
+                                        }
+                                    }
+
+                                    // Closing the socket also unblocks the
+                                    // backchannel reader sharing it.
+                                    queue.close();
+                                    socket.close();
+
+                                    log::info!("transport subscriber writer is closed");
+                                });
                         }
+
+                        // The receiver uses the reverse direction of the
+                        // same socket as a backchannel, currently only to
+                        // request an immediate keyframe. The reader thread
+                        // lives as long as the peer does, it exits as soon
+                        // as the socket errors out.
+                        let key_frame_request = key_frame_request_.clone();
+                        let _ = thread::Builder::new()
+                            .name("HylaranaTransportBackchannelThread".to_string())
+                            .spawn(move || {
+                                let mut buffer = [0u8; 64];
+                                while let Ok(size) = socket.read(&mut buffer) {
+                                    if size == 0 {
+                                        break;
+                                    }
+
+                                    if size == KEY_FRAME_REQUEST.len()
+                                        && buffer[..2] == KEY_FRAME_REQUEST[..2]
+                                        && (buffer[2] as usize) < MAX_VIDEO_TRACKS
+                                    {
+                                        key_frame_request
+                                            .fetch_or(1 << buffer[2], Ordering::Relaxed);
+                                    }
+                                }
+
+                                // The read failing is how a peer disconnect
+                                // surfaces, wake the writer so the subscriber
+                                // gets pruned.
+                                queue.close();
+                            });
+
+                        log::info!("transport srt server accept a socket, addr={}", addr);
                     }
 
                     log::info!("transport srt server is closed, addr={}", address);
@@ -362,37 +851,111 @@ mod sender {
                     working_.store(false, Ordering::Relaxed);
                 })?;
 
+            let encoder = FragmentEncoder::new(options.mtu as usize);
+            let freelist = encoder.freelist();
+
             Ok(Self {
-                encoder: Mutex::new(FragmentEncoder::new(options.mtu as usize)),
-                producer: Default::default(),
+                producer: StreamProducer::new(options.audio_batch as usize),
+                encoder: Mutex::new(encoder),
+                fec: Default::default(),
+                key_frame_request,
+                subscribers,
+                freelist,
                 address,
                 working,
-                socket,
                 server,
             })
         }
 
+        /// Returns true if a receiver asked for an immediate keyframe on the
+        /// given video track over the backchannel since the last call. The
+        /// flag is cleared by reading it, the track's video encoder is
+        /// expected to act on it once.
+        pub fn take_key_frame_request(&self, track: u8) -> bool {
+            let mask = 1u8 << (track as usize % MAX_VIDEO_TRACKS);
+            self.key_frame_request.fetch_and(!mask, Ordering::Relaxed) & mask != 0
+        }
+
+        /// Takes a snapshot of the connection statistics, the basis for the
+        /// closed-loop rate control on top of the transport.
+        ///
+        /// With several subscribers connected this reports the worst link:
+        /// the shared encode has to fit the slowest viewer, anything faster
+        /// only rides out loss through its own queue's drop policy.
+        ///
+        /// Returns `None` while no receiver is connected.
+        pub fn get_stats(&self) -> Option<TransportSenderStats> {
+            let subscribers = self.subscribers.lock().clone();
+
+            let mut worst: Option<(f64, TransportSenderStats)> = None;
+            for subscriber in subscribers {
+                if let Ok(stats) = subscriber.socket.get_stats() {
+                    let loss_rate = stats.loss_rate();
+                    let stats = TransportSenderStats {
+                        rtt_ms: stats.msRTT,
+                        bandwidth_mbps: stats.mbpsBandwidth,
+                        send_rate_mbps: stats.mbpsSendRate,
+                        send_buffer_ms: stats.msSndBuf as u32,
+                        lost_packets: stats.pktSndLoss as u64,
+                        retransmitted_packets: stats.pktRetrans as u64,
+                        sent_packets: stats.pktSent as u64,
+                    };
+
+                    if worst
+                        .as_ref()
+                        .map(|(it, _)| loss_rate > *it)
+                        .unwrap_or(true)
+                    {
+                        worst = Some((loss_rate, stats));
+                    }
+                }
+            }
+
+            let (loss_rate, stats) = worst?;
+
+            // Every statistics window also feeds the FEC controller, so the
+            // redundancy the listener hands out tracks what the worst link
+            // actually loses.
+            if let Some(config) = self.fec.lock().update(loss_rate) {
+                if let Err(e) = self.server.set_fec(config) {
+                    log::warn!("transport failed to update fec config, err={:?}", e);
+                } else {
+                    log::info!("transport fec config updated, config={:?}", config);
+                }
+            }
+
+            Some(stats)
+        }
+
         /// Calculates and returns the packet loss rate
         /// Returns a value between 0.0 and 1.0
+        ///
+        /// With several subscribers connected this is the worst rate among
+        /// them, for the same reason `get_stats` reports the worst link.
         pub fn get_pkt_lose_rate(&self) -> f64 {
-            if let Some(socket) = self.socket.load().as_ref() {
+            let subscribers = self.subscribers.lock().clone();
+
+            let mut rate: f64 = 0.0;
+            for subscriber in subscribers {
                 if let Ok(SRT_TRACEBSTATS {
                     pktSndDrop,
                     pktSentUnique,
                     ..
-                }) = socket.get_stats()
+                }) = subscriber.socket.get_stats()
                 {
                     log::info!(
-                        "transport pkt send drop={}, send count={}",
+                        "transport pkt send drop={}, send count={}, addr={}",
                         pktSndDrop,
-                        pktSentUnique
+                        pktSentUnique,
+                        subscriber.addr
                     );
 
-                    return (pktSndDrop as f64 / pktSentUnique as f64 * 10.0).floor() / 10.0;
+                    rate =
+                        rate.max((pktSndDrop as f64 / pktSentUnique as f64 * 10.0).floor() / 10.0);
                 }
             }
 
-            0.0
+            rate
         }
 
         /// Sends data through the SRT connection
@@ -406,34 +969,56 @@ mod sender {
                 return Ok(());
             }
 
-            let mut is_close = false;
-            {
-                let socket = self.socket.load();
-                let mut encoder = self.encoder.lock();
-
-                // Process and send each filtered buffer
-                for buffer in self.producer.filter(buffer) {
-                    if let Some(socket) = socket.as_ref() {
-                        for chunk in encoder.encode(&buffer) {
-                            if let Err(e) = socket.send(chunk) {
-                                log::warn!(
-                                    "transport failed to send data with srt current socket, err={:?}",
-                                    e
-                                );
-
-                                is_close = true;
-                                break;
-                            }
-                        }
-                    } else {
-                        break;
-                    }
-                }
+            // Every thread pushing into the sender keeps its own batch, so
+            // the audio and video senders never contend on a shared scratch
+            // buffer while a keyframe is being flushed.
+            thread_local! {
+                static BATCH: RefCell<Vec<BytesMut>> = RefCell::new(Vec::new());
             }
 
-            if is_close {
-                self.socket.store(None);
-            }
+            // The messages the producer expands this buffer into all travel
+            // under its tag, so the config it injects in front of a keyframe
+            // resynchronizes a stalled subscriber together with the keyframe
+            // itself.
+            let stream = buffer.stream;
+            let track = buffer.track;
+            let ty = buffer.ty;
+
+            BATCH.with_borrow_mut(|batch| {
+                // Process and fan out each filtered buffer
+                for frame in self.producer.filter(buffer) {
+                    // Fragment the message while holding the encoder lock,
+                    // but fan it out only after the lock has been released,
+                    // a keyframe worth of fragments no longer serializes the
+                    // other sender threads.
+                    self.encoder.lock().encode(&frame, batch);
+
+                    // Freezing lets the subscriber queues share the
+                    // fragments by refcount, a ten viewer broadcast ships
+                    // the same bytes ten times without copying them once.
+                    // The packet carries the freelist handle, so the storage
+                    // returns to the encoder when the last queue drops it.
+                    let packet = Arc::new(SendPacket {
+                        fragments: batch.drain(..).map(BytesMut::freeze).collect(),
+                        freelist: self.freelist.clone(),
+                        stream,
+                        track,
+                        ty,
+                    });
+
+                    // The fragments have been handed off, the frame buffer
+                    // can go back to the pool for the next frame.
+                    super::pool::release(frame);
+
+                    // A refused push is a subscriber whose writer already
+                    // shut down, prune it on the way through. A dead peer
+                    // only ever costs its own queue, the session stays up
+                    // for everyone else.
+                    self.subscribers
+                        .lock()
+                        .retain(|subscriber| subscriber.queue.push(packet.clone()));
+                }
+            });
 
             Ok(())
         }
@@ -448,6 +1033,13 @@ mod sender {
             log::info!("transport sender is drop");
 
             self.server.close();
+
+            // Wake every writer thread so the subscriber sockets get closed
+            // and the threads exit instead of parking on their queues
+            // forever.
+            for subscriber in self.subscribers.lock().drain(..) {
+                subscriber.queue.close();
+            }
         }
     }
 }
@@ -0,0 +1,90 @@
+// Recycling pool for frame-sized transport buffers
+//
+// Every frame pushed into the transport used to allocate a fresh `BytesMut`,
+// which for 4K keyframes means multi-megabyte allocations at the frame rate of
+// the stream. The pool keeps a small number of buffers per size class and
+// hands them back out on the next frame, so steady-state streaming does not
+// touch the heap allocator on the send hot path at all.
+
+use std::sync::LazyLock;
+
+use bytes::BytesMut;
+use parking_lot::Mutex;
+
+// The size classes are chosen for the traffic the transport actually carries:
+// audio packets and video p-frames at the low end, 4K keyframes at the high
+// end. Anything larger than the biggest class is allocated directly and not
+// recycled.
+const SIZE_CLASSES: [usize; 4] = [64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024];
+
+// Number of buffers kept per size class. Audio and video senders plus the
+// config frame duplication never have more buffers in flight than this, so a
+// small fixed number is enough to make the steady state allocation free.
+const SLOTS_PER_CLASS: usize = 8;
+
+static POOL: LazyLock<BufferPool> = LazyLock::new(BufferPool::default);
+
+/// Takes a buffer with at least the given capacity from the pool, allocating
+/// a new one only if the matching size class is empty. The returned buffer is
+/// always empty.
+pub(crate) fn acquire(capacity: usize) -> BytesMut {
+    POOL.acquire(capacity)
+}
+
+/// Returns a buffer to the pool so the next `acquire` can reuse it. Buffers
+/// larger than the biggest size class or beyond the per-class capacity are
+/// simply dropped.
+pub(crate) fn release(bytes: BytesMut) {
+    POOL.release(bytes)
+}
+
+#[derive(Default)]
+struct BufferPool {
+    // Each slot is guarded by its own mutex, but the pool only ever uses
+    // `try_lock`, so the hot path never blocks, in the worst case a buffer is
+    // allocated or dropped as if there were no pool at all.
+    classes: [[Mutex<Option<BytesMut>>; SLOTS_PER_CLASS]; SIZE_CLASSES.len()],
+}
+
+impl BufferPool {
+    fn acquire(&self, capacity: usize) -> BytesMut {
+        if let Some(class) = SIZE_CLASSES.iter().position(|size| capacity <= *size) {
+            for slot in &self.classes[class] {
+                if let Some(mut slot) = slot.try_lock() {
+                    if let Some(bytes) = slot.take() {
+                        return bytes;
+                    }
+                }
+            }
+
+            BytesMut::with_capacity(SIZE_CLASSES[class])
+        } else {
+            BytesMut::with_capacity(capacity)
+        }
+    }
+
+    fn release(&self, mut bytes: BytesMut) {
+        // The buffer may have grown since it was acquired, so it is filed
+        // under the largest class it can still serve.
+        let mut class = None;
+        for (i, size) in SIZE_CLASSES.iter().enumerate() {
+            if bytes.capacity() >= *size {
+                class = Some(i);
+            }
+        }
+
+        if let Some(class) = class {
+            bytes.clear();
+
+            for slot in &self.classes[class] {
+                if let Some(mut slot) = slot.try_lock() {
+                    if slot.is_none() {
+                        slot.replace(bytes);
+
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -8,12 +8,14 @@ use std::{
     mem::MaybeUninit,
     net::SocketAddr,
     ptr::null_mut,
+    sync::Arc,
 };
 
 use bytes::{Buf, BufMut, Bytes, BytesMut};
 use common::strings::PSTR;
 use log::{Level, log};
 use os_socketaddr::OsSocketAddr;
+use parking_lot::Mutex;
 
 pub use self::sys::SRT_TRACEBSTATS;
 
@@ -151,7 +153,13 @@ impl SrtOptions {
         set_sock_opt(fd, sys::SRT_SOCKOPT::SRTO_PEERIDLETIMEO, &self.timeout)?;
 
         // Set packet filter (FEC configuration)
-        set_sock_opt_str(fd, sys::SRT_SOCKOPT::SRTO_PACKETFILTER, &self.fec)?;
+        //
+        // An empty config leaves the filter unset, which on a caller socket
+        // means the geometry dictated by the listener is accepted during the
+        // handshake.
+        if !self.fec.is_empty() {
+            set_sock_opt_str(fd, sys::SRT_SOCKOPT::SRTO_PACKETFILTER, &self.fec)?;
+        }
 
         Ok(())
     }
@@ -191,6 +199,18 @@ fn set_sock_opt<T: Sized + Debug + PartialEq>(
     }
 }
 
+// Helper function to read socket options with type safety
+fn get_sock_opt<T: Sized + Default>(sock: sys::SRTSOCKET, opt: sys::SRT_SOCKOPT) -> Option<T> {
+    let mut value = T::default();
+    let mut len = size_of::<T>() as c_int;
+
+    if unsafe { sys::srt_getsockflag(sock, opt, &mut value as *mut T as *mut _, &mut len) } == 0 {
+        Some(value)
+    } else {
+        None
+    }
+}
+
 // Helper function to set string socket options
 fn set_sock_opt_str(sock: sys::SRTSOCKET, opt: sys::SRT_SOCKOPT, flag: &str) -> Result<(), Error> {
     if unsafe {
@@ -208,11 +228,42 @@ fn set_sock_opt_str(sock: sys::SRTSOCKET, opt: sys::SRT_SOCKOPT, flag: &str) ->
     }
 }
 
+// Shared freelist of fragment-sized packet buffers.
+//
+// Fragments frozen for fan-out outlive the encoder call that produced them,
+// so the freelist is a handle that can travel with the in-flight packet and
+// take the storage back once the last reader has let go of it.
+#[derive(Default, Clone)]
+pub struct FragmentFreelist(Arc<Mutex<Vec<BytesMut>>>);
+
+impl FragmentFreelist {
+    // Bounds the freelist so a loss burst parking many packets in subscriber
+    // queues does not turn into permanently retained memory. At fragment
+    // size this caps the list at a few megabytes.
+    const CAPACITY: usize = 4096;
+
+    fn pop(&self) -> Option<BytesMut> {
+        self.0.lock().pop()
+    }
+
+    // Recovers the storage of a fragment that was frozen for fan-out. A
+    // fragment still shared with another reader, or one over the capacity
+    // bound, is simply dropped.
+    pub fn release(&self, fragment: Bytes) {
+        if let Ok(bytes) = fragment.try_into_mut() {
+            let mut packets = self.0.lock();
+            if packets.len() < Self::CAPACITY {
+                packets.push(bytes);
+            }
+        }
+    }
+}
+
 // Fragment encoder for breaking large messages into smaller packets
 pub struct FragmentEncoder {
-    max_pkt_size: usize,    // Maximum packet size
-    packets: Vec<BytesMut>, // Buffer for packet fragments
-    sequence: u32,          // Sequence number for packet ordering
+    max_pkt_size: usize,       // Maximum packet size
+    packets: FragmentFreelist, // Freelist of recycled packet fragments
+    sequence: u32,             // Sequence number for packet ordering
 }
 
 impl FragmentEncoder {
@@ -227,36 +278,43 @@ impl FragmentEncoder {
         }
     }
 
-    // Encode a message into multiple fragments
-    pub fn encode(&mut self, bytes: &[u8]) -> &[BytesMut] {
-        let mut size = 0;
+    // Hands out the freelist the encoder draws from, for returning fragment
+    // storage after the batch has left the encoder's hands.
+    pub fn freelist(&self) -> FragmentFreelist {
+        self.packets.clone()
+    }
 
+    // Encode a message into multiple fragments, moving the finished chunks
+    // into the caller-provided batch.
+    //
+    // The chunks are taken from the freelist, the caller is expected to hand
+    // them back through `recycle` (or `FragmentFreelist::release` once they
+    // have been frozen) after the batch has been submitted, so the encoder
+    // lock does not need to be held while the socket flushes the batch.
+    pub fn encode(&mut self, bytes: &[u8], batch: &mut Vec<BytesMut>) {
         // Split message into chunks that fit within max_pkt_size
-        for (i, chunk) in bytes
-            .chunks(self.max_pkt_size - Self::HEAD_SIZE)
-            .enumerate()
-        {
-            {
-                if self.packets.get(i).is_none() {
-                    self.packets
-                        .push(BytesMut::with_capacity(self.max_pkt_size));
-                }
-            }
+        for chunk in bytes.chunks(self.max_pkt_size - Self::HEAD_SIZE) {
+            let mut buf = self
+                .packets
+                .pop()
+                .unwrap_or_else(|| BytesMut::with_capacity(self.max_pkt_size));
 
-            if let Some(buf) = self.packets.get_mut(i) {
-                buf.clear();
+            buf.clear();
 
-                // Add sequence number and total size to header
-                buf.put_u32(self.sequence);
-                buf.put_u32(bytes.len() as u32);
-                buf.extend_from_slice(chunk);
+            // Add sequence number and total size to header
+            buf.put_u32(self.sequence);
+            buf.put_u32(bytes.len() as u32);
+            buf.extend_from_slice(chunk);
 
-                size += 1;
-            }
+            batch.push(buf);
         }
 
         self.sequence = self.sequence.wrapping_add(1);
-        &self.packets[..size]
+    }
+
+    // Returns a submitted batch of chunks to the freelist.
+    pub fn recycle(&mut self, batch: &mut Vec<BytesMut>) {
+        self.packets.0.lock().append(batch);
     }
 }
 
@@ -310,6 +368,57 @@ impl FragmentDecoder {
     }
 }
 
+// Reusable arena for draining all queued messages from a socket in one go.
+//
+// Messages are packed back to back into a single buffer that is reused across
+// wakeups, so the batched receive path does not allocate per packet.
+pub struct RecvArena {
+    bytes: Vec<u8>,
+    messages: Vec<(usize, usize)>,
+}
+
+impl Default for RecvArena {
+    fn default() -> Self {
+        Self {
+            bytes: vec![0u8; Self::MESSAGE_SIZE * 64],
+            messages: Vec::with_capacity(64),
+        }
+    }
+}
+
+impl RecvArena {
+    // A single SRT message in live mode never exceeds the payload size of one
+    // packet, but leave the same headroom the old single-read loop used.
+    const MESSAGE_SIZE: usize = 4096;
+
+    fn clear(&mut self) {
+        self.messages.clear();
+    }
+
+    // Makes room for one more message and returns the writable slot for it.
+    fn chunk(&mut self) -> &mut [u8] {
+        let offset = self.messages.last().map(|(a, b)| a + b).unwrap_or(0);
+        if self.bytes.len() < offset + Self::MESSAGE_SIZE {
+            self.bytes.resize(offset + Self::MESSAGE_SIZE, 0);
+        }
+
+        &mut self.bytes[offset..offset + Self::MESSAGE_SIZE]
+    }
+
+    // Marks the last chunk as filled with a message of the given size.
+    fn commit(&mut self, size: usize) {
+        let offset = self.messages.last().map(|(a, b)| a + b).unwrap_or(0);
+        self.messages.push((offset, size));
+    }
+
+    /// Iterates over all messages received in the last batch.
+    pub fn iter(&self) -> impl Iterator<Item = &[u8]> {
+        self.messages
+            .iter()
+            .map(|(offset, size)| &self.bytes[*offset..offset + size])
+    }
+}
+
 // SRT socket wrapper for client connections
 // Provides a safe interface to interact with SRT sockets
 pub struct SrtSocket {
@@ -365,6 +474,36 @@ impl SrtSocket {
         Ok(size as usize)
     }
 
+    // Drains every message currently queued on the socket into the arena.
+    //
+    // Blocks for the first message like `read`, then pulls everything that has
+    // already been acknowledged by the receive buffer without waiting, so one
+    // wakeup hands the decoder a whole burst instead of a single packet.
+    // Returns the number of messages received, 0 means the socket is closed.
+    pub fn read_batch(&self, arena: &mut RecvArena) -> Result<usize, Error> {
+        arena.clear();
+
+        let size = self.read(arena.chunk())?;
+        if size == 0 {
+            return Ok(0);
+        }
+
+        arena.commit(size);
+
+        // SRTO_RCVDATA reports how many acknowledged packets are ready in the
+        // receive buffer, reading exactly that many never blocks.
+        for _ in 0..get_sock_opt::<i32>(self.fd, sys::SRT_SOCKOPT::SRTO_RCVDATA).unwrap_or(0) {
+            let size = self.read(arena.chunk())?;
+            if size == 0 {
+                break;
+            }
+
+            arena.commit(size);
+        }
+
+        Ok(arena.messages.len())
+    }
+
     // Send data through the socket
     // Note: Data size must not exceed MTU size, use FragmentEncoder for larger
     // messages
@@ -448,6 +587,15 @@ impl SrtServer {
         Err(current_error())
     }
 
+    // Replaces the FEC configuration of the listening socket.
+    //
+    // The packet filter is a handshake-time option in SRT, connections that
+    // are already up keep whatever they negotiated; the new geometry applies
+    // to every connection accepted from now on.
+    pub fn set_fec(&self, fec: &str) -> Result<(), Error> {
+        set_sock_opt_str(self.fd, sys::SRT_SOCKOPT::SRTO_PACKETFILTER, fec)
+    }
+
     /// Extracts the address to which the socket was bound. Although you should
     /// know the address(es) that you have used for binding yourself, this
     /// function can be useful for extracting the local outgoing port number